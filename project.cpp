@@ -9,18 +9,56 @@
 #include <fcntl.h>      // File control ke liye
 #include <sys/stat.h>   // File status ke liye
 #include <cerrno>       // Error handling ke liye
+#include <csignal>      // Daemon shutdown signals ke liye
+#include <ctime>        // Latency measure karne ke liye (clock_gettime)
+#include <sys/socket.h> // Unix domain socket (daemon mode)
+#include <sys/un.h>     // sockaddr_un ke liye
+#include <sys/mman.h>   // Shared memory (activation cache) ke liye
+#include <cstdint>      // uint64_t hashes ke liye
+#include <cstddef>      // offsetof (weight cache header)
+#include <cmath>        // isfinite (iterative mode divergence check)
+#include <netinet/in.h> // TCP transport (distributed stages)
+#include <netinet/tcp.h>// TCP_NODELAY, TCP_CORK
+#include <arpa/inet.h>  // htons/ntohs
+#include <netdb.h>      // getaddrinfo
+#include <sys/syscall.h>   // io_uring_setup/io_uring_enter (liburing ke bina)
+#include <sys/uio.h>       // struct iovec
+#include <linux/io_uring.h>// io_uring ring layout
+#include <linux/futex.h>   // Low-latency slots ka park/wake
+#include <sched.h>         // sched_setaffinity, sched_yield
+#include <sys/ioctl.h>     // FIONREAD (live metrics queue depth)
+#include <poll.h>          // Launcher ka timeout ke saath intezar
+#include <climits>         // INT_MAX (per-layer cache size ka overflow check)
 
 // Constants - fixed values
 const int MAX_NEURONS = 100;      // Maximum neurons per layer
 const int INPUT_NEURONS = 2;       // Input layer mein 2 neurons hain
 const int BUFFER_SIZE = 8192;     // Buffer size for data transfer
+const int MAX_HIDDEN_LAYERS = 9;  // Maximum hidden layers
+const int MAX_STAGES = 2 * (MAX_HIDDEN_LAYERS + 2);  // Dono passes ke saare layer stages
 
-// Thread data structure - har neuron thread ke liye data (C++ struct)
+// Daemon mode constants
+const int DEFAULT_MAX_BATCH = 32;          // Ek micro-batch mein zyada se zyada requests
+const int DEFAULT_BATCH_WINDOW_US = 500;   // Batch bharne ke liye max intezar (latency budget)
+const int MAX_BATCH = 256;                 // --max-batch ki upper limit
+const int LATENCY_SAMPLES = 4096;          // Percentiles ke liye aakhri itni latencies yaad rakho
+const int DEFAULT_CACHE_ENTRIES = 4096;    // --cache ke bina size diye to itni entries
+const double DEFAULT_TOLERANCE = 1e-6;     // Iterative mode convergence tolerance
+const int DEFAULT_SPLIT_K_CHUNK = 32;      // Split-K mode mein ek chunk ke inputs
+const int MAX_SPLIT_K_THREADS = 256;       // --split-k ki upper limit (har layer process mein)
+const int PANEL_WIDTH = 4;                 // Ek weight panel ke neurons (4 doubles = ek 256-bit vector)
+const size_t WEIGHT_ALIGNMENT = 64;        // Packed weights cache line par shuru hote hain
+
+// Thread data structure - har panel thread ke liye data (C++ struct)
+// Ek thread ek weight panel (PANEL_WIDTH neurons) ka kaam karta hai
 struct ComputeThread {
-    int thread_id;              // Thread ka unique ID
-    int input_size;             // Kitne inputs hain is neuron ko
+    int thread_id;              // Thread ka unique ID (panel number)
+    int panel_neurons;          // Is panel ke asli neurons (aakhri panel mein kam ho sakte hain)
+    int input_size;             // Kitne inputs hain har neuron ko
+    int batch_rows;             // Kitne input vectors (batch) process karne hain
+    int output_stride;          // Output array mein ek row ki width (num_neurons)
     double *layer_inputs;       // Previous layer se aane wale inputs
-    double *neuron_weights;     // Is neuron ke weights
+    double *neuron_weights;     // Is panel ke interleaved weights (input_size x PANEL_WIDTH)
     double *output_array;       // Output store karne ke liye array
     pthread_mutex_t *sync_lock; // Thread synchronization ke liye mutex
 };
@@ -28,6 +66,8 @@ struct ComputeThread {
 // Global variables - sab processes share karenge
 FILE *result_file;                              // Output file pointer
 pthread_mutex_t file_lock = PTHREAD_MUTEX_INITIALIZER;  // File writing ke liye mutex
+int split_k_threads = 0;                        // --split-k: 0 = har weight panel ek thread (default)
+int split_k_chunk = DEFAULT_SPLIT_K_CHUNK;      // --split-k-chunk: reduction chunk size
 
 // Input file se comma-separated values parse karne ka function
 // Yeh function input.txt se numbers read karta hai jo commas se separated hain
@@ -69,46 +109,215 @@ int validate_file_exists(const char *path) {
     return 1;  // File mil gayi
 }
 
-// Har neuron thread yeh function execute karta hai
-// Yeh weighted sum calculate karta hai: sum = input1*weight1 + input2*weight2 + ...
+// Har panel thread yeh function execute karta hai
+// Har neuron ka weighted sum: sum = input1*weight1 + input2*weight2 + ...
+// Panel mein input j ke PANEL_WIDTH weights saath-saath hain, isliye weights unit
+// stride se stream hote hain aur har neuron ka sum purane order mein hi judta hai
 void *execute_neuron_task(void *params) {
     ComputeThread *task = static_cast<ComputeThread *>(params);
-    double sum = 0.0;
+    const double *panel = task->neuron_weights;
     
-    // Sab inputs ko unke weights se multiply karke sum mein add karo
-    for (int j = 0; j < task->input_size; j++) {
-        sum += task->layer_inputs[j] * task->neuron_weights[j];
+    // Batch ki har row ke liye panel ke saare neurons apna weighted sum nikalte hain
+    for (int r = 0; r < task->batch_rows; r++) {
+        const double *row_inputs = &task->layer_inputs[r * task->input_size];
+        double sum[PANEL_WIDTH] = {0.0};
+        
+        // Sab inputs ko unke weights se multiply karke sum mein add karo
+        for (int j = 0; j < task->input_size; j++) {
+            for (int k = 0; k < PANEL_WIDTH; k++) {
+                sum[k] += row_inputs[j] * panel[j * PANEL_WIDTH + k];
+            }
+        }
+        
+        // Mutex lock karo taake output array safely update ho sake (padding lanes skip)
+        pthread_mutex_lock(task->sync_lock);
+        double *out_row = &task->output_array[r * task->output_stride + task->thread_id * PANEL_WIDTH];
+        for (int k = 0; k < task->panel_neurons; k++) {
+            out_row[k] = sum[k];  // Result store karo
+        }
+        pthread_mutex_unlock(task->sync_lock);
     }
     
-    // Mutex lock karo taake output array safely update ho sake
-    pthread_mutex_lock(task->sync_lock);
-    task->output_array[task->thread_id] = sum;  // Result store karo
-    pthread_mutex_unlock(task->sync_lock);
-    
     pthread_exit(NULL);  // Thread complete
 }
 
-// Ek layer ke saare neurons ke liye threads create karta hai
-// Har neuron parallel mein compute karega (multi-core advantage)
-double* launch_neuron_threads(int num_neurons, int input_size, 
-                              double *input_data, double *weights) {
-    // Results store karne ke liye memory allocate karo
-    double *results = static_cast<double *>(malloc(num_neurons * sizeof(double)));
-    if (!results) {
+// ========== SPLIT-K REDUCTION ==========
+// Bahut wide inputs aur kam neurons ho to ek neuron ka poora dot product ek hi
+// thread par chalta hai aur baaki cores khali rehte hain. Split-K mode mein har
+// neuron ka input dimension fixed-size chunks mein bant jata hai; threads chunks
+// ke partial sums nikalte hain aur phir ek fixed tree order mein jode jate hain.
+// Chunk size fixed hai isliye result thread count se bilkul (bitwise) independent hai.
+
+// Split-K ka work - har thread (row, neuron, chunk) items ki ek range karta hai
+struct SplitKTask {
+    int first_item, last_item;  // [first, last) - flat (row, neuron, chunk) index
+    int num_neurons;
+    int input_size;
+    int chunk_count;            // Har neuron ke chunks
+    const double *input_data;
+    const double *weights;
+    double *partials;           // rows x neurons x chunk_count
+};
+
+void *execute_split_k_task(void *params) {
+    SplitKTask *task = static_cast<SplitKTask *>(params);
+    for (int item = task->first_item; item < task->last_item; item++) {
+        int chunk = item % task->chunk_count;
+        int neuron = (item / task->chunk_count) % task->num_neurons;
+        int row = item / (task->chunk_count * task->num_neurons);
+        
+        int begin = chunk * split_k_chunk;
+        int end = begin + split_k_chunk;
+        if (end > task->input_size) end = task->input_size;
+        
+        const double *row_inputs = &task->input_data[row * task->input_size];
+        const double *neuron_weights = &task->weights[neuron * task->input_size];
+        double sum = 0.0;
+        for (int j = begin; j < end; j++) {
+            sum += row_inputs[j] * neuron_weights[j];
+        }
+        task->partials[item] = sum;  // Har item ki apni jagah - lock ki zaroorat nahi
+    }
+    return NULL;
+}
+
+// Partial sums ko fixed pairwise tree mein jodo: (p0+p1)+(p2+p3)+...
+// Order sirf chunk_count par depend karta hai, threads par nahi
+double combine_partials_tree(double *partials, int count) {
+    for (int stride = 1; stride < count; stride *= 2) {
+        for (int i = 0; i + stride < count; i += 2 * stride) {
+            partials[i] += partials[i + stride];
+        }
+    }
+    return partials[0];
+}
+
+// Reduction order ki pehchan - split-K aur sequential ke results last bits mein alag
+// hote hain, isliye checkpoint aur cache keys mein yeh bhi shamil hota hai
+uint64_t reduction_signature() {
+    return split_k_threads > 0 ? (uint64_t)split_k_chunk << 32 : 0;
+}
+
+// Split-K path - saare (row, neuron, chunk) items threads mein barabar baanto
+void launch_split_k_into(int num_neurons, int input_size, int batch_rows,
+                         double *input_data, double *weights, double *results) {
+    int chunk_count = (input_size + split_k_chunk - 1) / split_k_chunk;
+    int total_items = batch_rows * num_neurons * chunk_count;
+    double *partials = static_cast<double *>(malloc(total_items * sizeof(double)));
+    if (!partials) {
+        fprintf(stderr, "ERROR: Memory allocation failed\n");
+        exit(1);
+    }
+    
+    // Items se zyada threads bekaar hain; arrays heap par (thread count user deta hai)
+    int thread_count = split_k_threads < total_items ? split_k_threads : total_items;
+    pthread_t *tid_array = static_cast<pthread_t *>(malloc(thread_count * sizeof(pthread_t)));
+    SplitKTask *tasks = static_cast<SplitKTask *>(malloc(thread_count * sizeof(SplitKTask)));
+    if (!tid_array || !tasks) {
+        fprintf(stderr, "ERROR: Memory allocation failed\n");
+        exit(1);
+    }
+    for (int t = 0; t < thread_count; t++) {
+        tasks[t].first_item = (long)total_items * t / thread_count;
+        tasks[t].last_item = (long)total_items * (t + 1) / thread_count;
+        tasks[t].num_neurons = num_neurons;
+        tasks[t].input_size = input_size;
+        tasks[t].chunk_count = chunk_count;
+        tasks[t].input_data = input_data;
+        tasks[t].weights = weights;
+        tasks[t].partials = partials;
+        pthread_create(&tid_array[t], NULL, execute_split_k_task, &tasks[t]);
+    }
+    for (int t = 0; t < thread_count; t++) {
+        pthread_join(tid_array[t], NULL);
+    }
+    free(tid_array);
+    free(tasks);
+    
+    // Deterministic combine - har (row, neuron) ke chunks usi tree order mein
+    for (int rn = 0; rn < batch_rows * num_neurons; rn++) {
+        results[rn] = combine_partials_tree(&partials[rn * chunk_count], chunk_count);
+    }
+    free(partials);
+}
+
+// Layer ka compute kernel - execution plan har stage ke liye ek baar chunta hai
+enum StageKernel {
+    KERNEL_NEURON_THREADS,  // Har weight panel ek thread (default) - weights packed panels mein
+    KERNEL_SPLIT_K          // Dot products chunks mein, deterministic tree combine - weights rows mein
+};
+
+// Wide inputs par split-K - ek se zyada chunk ho tabhi faida hai
+StageKernel choose_stage_kernel(int input_size) {
+    if (split_k_threads > 0 && input_size > split_k_chunk) return KERNEL_SPLIT_K;
+    return KERNEL_NEURON_THREADS;
+}
+
+// Neuron-threads kernel ke weights ka layout: PANEL_WIDTH neurons ka ek panel, panel ke
+// andar input j ke liye un neurons ke weights lagataar (w[n0][j], w[n1][j], ...).
+// Aakhri panel zero se pad hota hai; har panel cache line par aligned shuru hota hai.
+size_t packed_weight_count(int num_neurons, int input_size) {
+    int panels = (num_neurons + PANEL_WIDTH - 1) / PANEL_WIDTH;
+    return (size_t)panels * input_size * PANEL_WIDTH;
+}
+
+// Kernel ke layout mein stage ke weights kitne doubles hain
+size_t stage_weight_count(StageKernel kernel, int num_neurons, int input_size) {
+    if (kernel == KERNEL_SPLIT_K) return (size_t)num_neurons * input_size;
+    return packed_weight_count(num_neurons, input_size);
+}
+
+double *alloc_weight_buffer(size_t count) {
+    size_t bytes = (count * sizeof(double) + WEIGHT_ALIGNMENT - 1) / WEIGHT_ALIGNMENT * WEIGHT_ALIGNMENT;
+    double *weights = static_cast<double *>(aligned_alloc(WEIGHT_ALIGNMENT,
+                                                          bytes > 0 ? bytes : WEIGHT_ALIGNMENT));
+    if (!weights) {
         fprintf(stderr, "ERROR: Memory allocation failed\n");
         exit(1);
     }
+    return weights;
+}
+
+// Row-major weights (har neuron ki row, input.txt jaisa) ko panels mein pack karo
+double *pack_weight_panels(const double *rows, int num_neurons, int input_size) {
+    size_t count = packed_weight_count(num_neurons, input_size);
+    double *packed = alloc_weight_buffer(count);
+    memset(packed, 0, count * sizeof(double));
+    for (int n = 0; n < num_neurons; n++) {
+        double *panel = &packed[(size_t)(n / PANEL_WIDTH) * input_size * PANEL_WIDTH];
+        for (int j = 0; j < input_size; j++) {
+            panel[j * PANEL_WIDTH + n % PANEL_WIDTH] = rows[(size_t)n * input_size + j];
+        }
+    }
+    return packed;
+}
+
+// Chuna hua kernel poore batch par chalao
+// input_data: batch_rows x input_size, results: batch_rows x num_neurons (caller ka
+// buffer - resident workers isko har batch mein reuse karte hain)
+// weights: kernel ke layout mein (split-K: rows, neuron threads: packed panels)
+void launch_stage_kernel(StageKernel kernel, int num_neurons, int input_size, int batch_rows,
+                         double *input_data, double *weights, double *results) {
+    if (kernel == KERNEL_SPLIT_K) {
+        launch_split_k_into(num_neurons, input_size, batch_rows, input_data, weights, results);
+        return;
+    }
     
-    pthread_t tid_array[num_neurons];  // Thread IDs store karne ke liye
+    int panel_count = (num_neurons + PANEL_WIDTH - 1) / PANEL_WIDTH;
+    pthread_t tid_array[panel_count];  // Thread IDs store karne ke liye
     pthread_mutex_t compute_lock = PTHREAD_MUTEX_INITIALIZER;  // Synchronization ke liye
-    ComputeThread task_params[num_neurons];  // Har thread ke liye parameters
+    ComputeThread task_params[panel_count];  // Har thread ke liye parameters
     
-    // Har neuron ke liye thread create karo
-    for (int i = 0; i < num_neurons; i++) {
+    // Har panel ke liye thread create karo
+    for (int i = 0; i < panel_count; i++) {
+        int remaining = num_neurons - i * PANEL_WIDTH;
         task_params[i].thread_id = i;
+        task_params[i].panel_neurons = remaining < PANEL_WIDTH ? remaining : PANEL_WIDTH;
         task_params[i].input_size = input_size;
+        task_params[i].batch_rows = batch_rows;
+        task_params[i].output_stride = num_neurons;
         task_params[i].layer_inputs = input_data;
-        task_params[i].neuron_weights = &weights[i * input_size];  // Har neuron ke apne weights
+        task_params[i].neuron_weights = &weights[(size_t)i * input_size * PANEL_WIDTH];  // Apna panel
         task_params[i].output_array = results;
         task_params[i].sync_lock = &compute_lock;
         
@@ -117,23 +326,87 @@ double* launch_neuron_threads(int num_neurons, int input_size,
     }
     
     // Sab threads ke complete hone ka wait karo
-    for (int i = 0; i < num_neurons; i++) {
+    for (int i = 0; i < panel_count; i++) {
         pthread_join(tid_array[i], NULL);
     }
     
     pthread_mutex_destroy(&compute_lock);  // Mutex cleanup
+}
+
+// Ek layer ke saare neurons ke liye threads create karta hai, poore batch par
+// Har panel parallel mein compute karega (multi-core advantage)
+// weights: choose_stage_kernel(input_size) wale kernel ke layout mein
+void launch_neuron_threads_into(int num_neurons, int input_size, int batch_rows,
+                                double *input_data, double *weights, double *results) {
+    launch_stage_kernel(choose_stage_kernel(input_size), num_neurons, input_size, batch_rows,
+                        input_data, weights, results);
+}
+
+// Naya result buffer allocate karke poore batch ke liye threads chalao
+double* launch_neuron_threads_batch(int num_neurons, int input_size, int batch_rows,
+                                    double *input_data, double *weights) {
+    // Results store karne ke liye memory allocate karo
+    double *results = static_cast<double *>(malloc(batch_rows * num_neurons * sizeof(double)));
+    if (!results) {
+        fprintf(stderr, "ERROR: Memory allocation failed\n");
+        exit(1);
+    }
+    launch_neuron_threads_into(num_neurons, input_size, batch_rows, input_data, weights, results);
     return results;  // Sab neurons ke results return karo
 }
 
+// Single input vector ke liye (normal simulation) - batch of one
+double* launch_neuron_threads(int num_neurons, int input_size, 
+                              double *input_data, double *weights) {
+    return launch_neuron_threads_batch(num_neurons, input_size, 1, input_data, weights);
+}
+
+// Pipe/socket par poora buffer likhne tak loop karo (partial writes handle karne ke liye)
+int write_full(int fd, const void *buf, size_t len) {
+    const char *p = static_cast<const char *>(buf);
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;  // Write fail
+        p += n;
+        len -= n;
+    }
+    return 1;
+}
+
+// Poora buffer read hone tak loop karo - bade batches pipe buffer se bade hote hain
+int read_full(int fd, void *buf, size_t len) {
+    char *p = static_cast<char *>(buf);
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;  // EOF ya read fail
+        p += n;
+        len -= n;
+    }
+    return 1;
+}
+
+// FNV-1a hash - weights version aur input keys dono ke liye
+uint64_t hash_doubles(const double *values, int count, uint64_t seed) {
+    uint64_t h = seed ^ 1469598103934665603ULL;
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(values);
+    for (size_t i = 0; i < count * sizeof(double); i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
 // Pipe mein data write karne ka function (IPC - Inter-Process Communication)
 // Ek process se doosre process ko data bhejne ke liye
 int write_to_pipe(int pipe_fd, double *data, int count) {
     // Pehle count bhejo (kitne values hain)
-    if (write(pipe_fd, &count, sizeof(int)) != sizeof(int)) {
+    if (!write_full(pipe_fd, &count, sizeof(int))) {
         return 0;  // Write fail
     }
     // Phir actual data bhejo
-    if (write(pipe_fd, data, count * sizeof(double)) != count * sizeof(double)) {
+    if (!write_full(pipe_fd, data, count * sizeof(double))) {
         return 0;  // Write fail
     }
     return 1;  // Success
@@ -144,7 +417,7 @@ int write_to_pipe(int pipe_fd, double *data, int count) {
 int read_from_pipe(int pipe_fd, double **data, int *count) {
     int n;
     // Pehle count read karo
-    if (read(pipe_fd, &n, sizeof(int)) != sizeof(int)) {
+    if (!read_full(pipe_fd, &n, sizeof(int)) || n <= 0) {
         return 0;  // Read fail
     }
     
@@ -156,570 +429,4011 @@ int read_from_pipe(int pipe_fd, double **data, int *count) {
     }
     
     // Actual data read karo
-    if (read(pipe_fd, *data, n * sizeof(double)) != n * sizeof(double)) {
+    if (!read_full(pipe_fd, *data, n * sizeof(double))) {
         free(*data);
         return 0;  // Read fail
     }
     return 1;  // Success
 }
 
-// Input layer process - yeh alag process hai (fork se create hua)
-// Input layer 2 neurons se start hoti hai
-void input_layer_process(int num_neurons, int neurons_per_layer, 
-                        int write_fd, int layer_id) {
-    printf("[LAYER %d] INPUT LAYER (PID: %d)\n", layer_id, getpid());
-    printf("  Input neurons: %d\n", INPUT_NEURONS);
-    
-    // Is process ke liye output file kholo (append mode for thread-safe writing)
-    FILE *local_result_file = fopen("output.txt", "a");
-    if (!local_result_file) {
-        fprintf(stderr, "ERROR: Cannot open output.txt\n");
-        exit(1);
-    }
-    
-    // Is process ke liye input file kholo
-    FILE *input_fp = fopen("input.txt", "r");
-    if (!input_fp) {
-        fprintf(stderr, "ERROR: Cannot open input.txt\n");
-        fclose(local_result_file);
-        exit(1);
-    }
-    
-    // Input values read karo (pehli line se)
-    double input_values[INPUT_NEURONS];
-    if (!parse_double_with_comma(input_fp, &input_values[0]) ||
-        !parse_double_with_comma(input_fp, &input_values[1])) {
-        fprintf(stderr, "ERROR: Failed to read initial input values\n");
-        fclose(input_fp);
-        exit(1);
+// Resident loops ke liye - caller ka buffer reuse karo, chhota pade to hi bada karo
+int read_from_pipe_into(int pipe_fd, double **buffer, int *capacity, int *count) {
+    int n;
+    if (!read_full(pipe_fd, &n, sizeof(int)) || n <= 0) {
+        return 0;  // EOF ya read fail
     }
-    
-    printf("  Values: [%.4f, %.4f]\n", input_values[0], input_values[1]);
-    
-    // Weights read karo (2 inputs * num_neurons weights)
-    double *weights = static_cast<double *>(malloc(INPUT_NEURONS * num_neurons * sizeof(double)));
-    for (int i = 0; i < INPUT_NEURONS * num_neurons; i++) {
-        if (!parse_double_with_comma(input_fp, &weights[i])) {
-            fprintf(stderr, "ERROR: Insufficient weight data\n");
-            exit(1);
+    if (n > *capacity) {
+        double *grown = static_cast<double *>(realloc(*buffer, n * sizeof(double)));
+        if (!grown) {
+            return 0;  // Memory allocation fail
         }
+        *buffer = grown;
+        *capacity = n;
     }
-    
-    // Threads create karke computation karo (har neuron ek thread hai)
-    double *output = launch_neuron_threads(num_neurons, INPUT_NEURONS, 
-                                           input_values, weights);
-    
-    // Output file mein result write karo (mutex se protect karke)
-    pthread_mutex_lock(&file_lock);
-    fprintf(local_result_file, "FORWARD PASS 1 - INPUT LAYER COMPUTATION\n");
-    fprintf(local_result_file, "Input: [%.6f, %.6f]\n", input_values[0], input_values[1]);
-    fprintf(local_result_file, "Output:\n");
-    for (int i = 0; i < num_neurons; i++) {
-        fprintf(local_result_file, "  Neuron[%d] = %.6f\n", i, output[i]);
-    }
-    fprintf(local_result_file, "\n");
-    fflush(local_result_file);  // Ensure data is written
-    pthread_mutex_unlock(&file_lock);
-    
-    // Next layer ko pipe se output bhejo (IPC)
-    if (!write_to_pipe(write_fd, output, num_neurons)) {
-        fprintf(stderr, "ERROR: Failed to write to pipe\n");
-        exit(1);
-    }
-    
-    // Cleanup - resources free karo
-    close(write_fd);
-    free(weights);
-    free(output);
-    fclose(input_fp);
-    fclose(local_result_file);
-    
-    printf("  Output sent to next layer (processing complete)\n\n");
-    exit(0);  // Process complete
+    *count = n;
+    return read_full(pipe_fd, *buffer, n * sizeof(double));
 }
 
-// Hidden layer process - har hidden layer alag process hai
-void hidden_layer_process(int layer_num, int num_neurons, 
-                         int read_fd, int write_fd, int total_hidden_layers) {
-    printf("[LAYER %d] HIDDEN LAYER (PID: %d)\n", layer_num, getpid());
-    printf("  Neurons: %d\n", num_neurons);
-    
-    // Is process ke liye output file kholo (append mode)
-    FILE *local_result_file = fopen("output.txt", "a");
-    if (!local_result_file) {
-        fprintf(stderr, "ERROR: Cannot open output.txt\n");
-        exit(1);
-    }
-    
-    // Is process ke liye input file kholo
-    FILE *input_fp = fopen("input.txt", "r");
-    if (!input_fp) {
-        fprintf(stderr, "ERROR: Cannot open input.txt\n");
-        fclose(local_result_file);
+// ========== SHARED-MEMORY SLOT RING (LOW-LATENCY HANDOFF) ==========
+// --low-latency mein resident stages pipe ki jagah shared memory ke slots se
+// activations dete hain. Consumer pehle spin karta hai, phir yield, phir futex par
+// park hota hai - spin budget har side apne hisaab se adapt karta hai (spin mein
+// data mil gaya to budget badhta hai, park karna pada to ghat jata hai).
+
+const int RING_SLOTS = 4;                  // Ek link par itne messages aage ja sakte hain
+const int RING_MIN_SPIN = 16;              // Adaptive spin budget ki range (cpu_relax rounds)
+const int RING_MAX_SPIN = 1 << 16;
+const int RING_INITIAL_SPIN = 1024;
+const int RING_YIELD_ROUNDS = 4;           // Spin ke baad park se pehle itni baar sched_yield
+
+int low_latency = 0;                       // --low-latency: global, fork hone wale stages dekhenge
+
+// Single producer / single consumer ring - producer aur consumer ke fields alag
+// cache lines par taake ek doosre ki line baar baar invalidate na karein
+struct SlotRing {
+    alignas(64) uint32_t tail;          // Producer ne kitne messages publish kiye (futex word)
+    uint32_t producer_waiting;          // Producer head par park hai
+    int producer_spin;                  // Producer ka adaptive spin budget
+    alignas(64) uint32_t head;          // Consumer ne kitne messages le liye (futex word)
+    uint32_t consumer_waiting;          // Consumer tail par park hai
+    int consumer_spin;
+    alignas(64) int slot_capacity;      // Ek slot mein max doubles
+    int counts[RING_SLOTS];             // Har slot ke message ki length (0 = EOF)
+    // Iske baad RING_SLOTS * slot_capacity doubles ka data
+};
+
+double *ring_slot_data(SlotRing *ring, int slot) {
+    return reinterpret_cast<double *>(ring + 1) + (size_t)slot * ring->slot_capacity;
+}
+
+void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#else
+    asm volatile("" ::: "memory");
+#endif
+}
+
+// Fork se pehle banao - dono processes isi MAP_SHARED memory ko dekhte hain
+SlotRing *create_slot_ring(int slot_capacity) {
+    size_t bytes = sizeof(SlotRing) + (size_t)RING_SLOTS * slot_capacity * sizeof(double);
+    void *mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap");
         exit(1);
     }
-    
-    // Pehle ki layers ke data skip karo (input values + input layer weights)
-    double dummy;
-    parse_double_with_comma(input_fp, &dummy);
-    parse_double_with_comma(input_fp, &dummy);
-    for (int i = 0; i < INPUT_NEURONS * num_neurons; i++) {
-        parse_double_with_comma(input_fp, &dummy);
-    }
-    
-    // Previous hidden layers ke weights skip karo
-    for (int i = 0; i < layer_num - 1; i++) {
-        for (int j = 0; j < num_neurons * num_neurons; j++) {
-            parse_double_with_comma(input_fp, &dummy);
+    SlotRing *ring = static_cast<SlotRing *>(mem);  // Anonymous memory pehle se zero hai
+    ring->slot_capacity = slot_capacity;
+    // Ek hi CPU ho to spin ka faida nahi (producer chal hi nahi sakta) - seedha park
+    int spin = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? RING_INITIAL_SPIN : 0;
+    ring->producer_spin = spin;
+    ring->consumer_spin = spin;
+    return ring;
+}
+
+// *word != value hone tak ruko - spin, phir yield, phir futex par park
+// *spin == 0: spin hi nahi (single CPU), seedha park
+void ring_wait(uint32_t *word, uint32_t value, uint32_t *waiting, int *spin) {
+    if (*spin > 0) {
+        for (int i = 0; i < *spin; i++) {
+            if (__atomic_load_n(word, __ATOMIC_ACQUIRE) != value) {
+                if (*spin < RING_MAX_SPIN) *spin *= 2;
+                return;
+            }
+            cpu_relax();
         }
-    }
-    
-    // Previous layer se pipe se input receive karo (IPC)
-    double *input_data;
-    int input_count;
-    if (!read_from_pipe(read_fd, &input_data, &input_count)) {
-        fprintf(stderr, "ERROR: Failed to read from pipe\n");
-        fclose(input_fp);
-        exit(1);
-    }
-    close(read_fd);
-    
-    // Apne layer ke weights read karo
-    double *weights = static_cast<double *>(malloc(input_count * num_neurons * sizeof(double)));
-    for (int i = 0; i < input_count * num_neurons; i++) {
-        if (!parse_double_with_comma(input_fp, &weights[i])) {
-            fprintf(stderr, "ERROR: Insufficient weight data\n");
-            fclose(input_fp);
-            exit(1);
+        for (int i = 0; i < RING_YIELD_ROUNDS; i++) {
+            sched_yield();  // Doosra side isi core par preempted ho sakta hai
+            if (__atomic_load_n(word, __ATOMIC_ACQUIRE) != value) return;
         }
+        if (*spin > RING_MIN_SPIN) *spin /= 2;
     }
     
-    // Threads create karke computation karo
-    double *output = launch_neuron_threads(num_neurons, input_count, 
-                                           input_data, weights);
-    
-    // Output file mein result write karo
-    pthread_mutex_lock(&file_lock);
-    fprintf(local_result_file, "FORWARD PASS 1 - HIDDEN LAYER %d COMPUTATION\n", layer_num);
-    fprintf(local_result_file, "Output:\n");
-    for (int i = 0; i < num_neurons; i++) {
-        fprintf(local_result_file, "  Neuron[%d] = %.6f\n", i, output[i]);
-    }
-    fprintf(local_result_file, "\n");
-    fflush(local_result_file);
-    pthread_mutex_unlock(&file_lock);
-    
-    // Next layer ko pipe se output bhejo
-    if (!write_to_pipe(write_fd, output, num_neurons)) {
-        fprintf(stderr, "ERROR: Failed to write to pipe\n");
-        exit(1);
+    // Park - waiting flag aur word ka check dono seq_cst, taake waker ka wake miss na ho
+    while (1) {
+        __atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(word, __ATOMIC_SEQ_CST) != value) break;
+        syscall(SYS_futex, word, FUTEX_WAIT, value, NULL, NULL, 0);
     }
-    
-    // Cleanup
-    close(write_fd);
-    free(input_data);
-    free(weights);
-    free(output);
-    fclose(input_fp);
-    fclose(local_result_file);
-    
-    printf("  Processing complete\n\n");
-    exit(0);
+    __atomic_store_n(waiting, 0, __ATOMIC_RELAXED);
 }
 
-// Output layer process
-void output_layer_process(int layer_num, int num_neurons, 
-                         int read_fd, int backward_write_fd, int total_hidden_layers) {
-    printf("[LAYER %d] OUTPUT LAYER (PID: %d)\n", layer_num, getpid());
-    printf("  Neurons: %d\n", num_neurons);
-    
-    // Is process ke liye output file kholo (append mode)
-    FILE *local_result_file = fopen("output.txt", "a");
-    if (!local_result_file) {
-        fprintf(stderr, "ERROR: Cannot open output.txt\n");
-        exit(1);
+// Word badalne ke baad - doosra side park ho to hi syscall
+void ring_wake(uint32_t *word, uint32_t *waiting) {
+    if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST)) {
+        syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
     }
-    
-    // Open input file for this process
-    FILE *input_fp = fopen("input.txt", "r");
-    if (!input_fp) {
-        fprintf(stderr, "ERROR: Cannot open input.txt\n");
-        fclose(local_result_file);
-        exit(1);
+}
+
+// Ek message slot mein daalo - count 0 EOF hai
+int ring_send(SlotRing *ring, const double *data, int count) {
+    if (count > ring->slot_capacity) {
+        fprintf(stderr, "ERROR: Message of %d values exceeds ring slot (%d) (PID: %d)\n",
+                count, ring->slot_capacity, getpid());
+        return 0;
     }
-    
-    // Skip input values (2 values) and input layer weights
-    double dummy;
-    parse_double_with_comma(input_fp, &dummy);
-    parse_double_with_comma(input_fp, &dummy);
-    for (int i = 0; i < INPUT_NEURONS * num_neurons; i++) {
-        parse_double_with_comma(input_fp, &dummy);
+    uint32_t tail = ring->tail;  // Sirf producer likhta hai
+    uint32_t head;
+    while (tail - (head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) == (uint32_t)RING_SLOTS) {
+        ring_wait(&ring->head, head, &ring->producer_waiting, &ring->producer_spin);
     }
-    
-    // Skip all hidden layer weights
-    for (int i = 0; i < total_hidden_layers; i++) {
-        for (int j = 0; j < num_neurons * num_neurons; j++) {
-            parse_double_with_comma(input_fp, &dummy);
+    int slot = tail % RING_SLOTS;
+    if (count > 0) memcpy(ring_slot_data(ring, slot), data, count * sizeof(double));
+    ring->counts[slot] = count;
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_SEQ_CST);
+    ring_wake(&ring->tail, &ring->consumer_waiting);
+    return 1;
+}
+
+// Agla message caller ke buffer mein copy karo - EOF par 0
+int ring_recv(SlotRing *ring, double **buffer, int *capacity, int *count) {
+    uint32_t head = ring->head;  // Sirf consumer likhta hai
+    ring_wait(&ring->tail, head, &ring->consumer_waiting, &ring->consumer_spin);
+    int slot = head % RING_SLOTS;
+    int n = ring->counts[slot];
+    if (n > *capacity) {
+        double *grown = static_cast<double *>(realloc(*buffer, n * sizeof(double)));
+        if (!grown) {
+            return 0;  // Memory allocation fail
         }
+        *buffer = grown;
+        *capacity = n;
     }
-    
-    // Read input from previous layer
-    double *input_data;
-    int input_count;
-    if (!read_from_pipe(read_fd, &input_data, &input_count)) {
-        fprintf(stderr, "ERROR: Failed to read from pipe\n");
-        fclose(input_fp);
-        exit(1);
-    }
-    close(read_fd);
-    
-    // Read weights
-    double *weights = (double *)malloc(input_count * num_neurons * sizeof(double));
-    for (int i = 0; i < input_count * num_neurons; i++) {
-        if (!parse_double_with_comma(input_fp, &weights[i])) {
-            fprintf(stderr, "ERROR: Insufficient weight data\n");
-            fclose(input_fp);
-            exit(1);
-        }
+    if (n > 0) memcpy(*buffer, ring_slot_data(ring, slot), n * sizeof(double));
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_SEQ_CST);
+    ring_wake(&ring->head, &ring->producer_waiting);
+    if (n <= 0) return 0;  // Producer ne chain band ki
+    *count = n;
+    return 1;
+}
+
+// Low-latency stage ko ek core par pin karo (index % online CPUs)
+void pin_to_cpu(int index) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % cpus, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        perror("sched_setaffinity");  // Pin na ho to bhi chalta hai, sirf warning
     }
-    
-    // Process with threads
-    double *output = launch_neuron_threads(num_neurons, input_count, 
-                                           input_data, weights);
-    
-    pthread_mutex_lock(&file_lock);
-    fprintf(local_result_file, "FORWARD PASS 1 - OUTPUT LAYER COMPUTATION\n");
-    fprintf(local_result_file, "Output:\n");
-    for (int i = 0; i < num_neurons; i++) {
-        fprintf(local_result_file, "  Output[%d] = %.6f\n", i, output[i]);
+}
+
+// ========== TRANSPORT (PIPE / TCP) ==========
+// Resident stages ek Channel se padhte aur doosre mein likhte hain. Ek hi machine
+// par yeh anonymous pipe hota hai; stages alag hosts par hon to TCP socket.
+
+enum ChannelKind {
+    PIPE_CHANNEL,   // write_to_pipe / read_from_pipe framing (int count)
+    TCP_CHANNEL,    // FrameHeader framing - bade messages ke liye 64-bit count
+    RING_CHANNEL    // Shared-memory slot ring (--low-latency), fd nahi hota
+};
+
+struct Channel {
+    ChannelKind kind;
+    int fd;                 // RING_CHANNEL mein -1
+    SlotRing *ring;         // Sirf RING_CHANNEL
+};
+
+// TCP frame header - har message ke aage
+struct FrameHeader {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t count;         // Kitne doubles aa rahe hain
+};
+
+const uint32_t FRAME_MAGIC = 0x4e4e4652;   // "NNFR"
+
+Channel make_channel(ChannelKind kind, int fd) {
+    Channel ch;
+    ch.kind = kind;
+    ch.fd = fd;
+    ch.ring = NULL;
+    return ch;
+}
+
+Channel make_ring_channel(SlotRing *ring) {
+    Channel ch = make_channel(RING_CHANNEL, -1);
+    ch.ring = ring;
+    return ch;
+}
+
+// Do stages ke beech ek link - --low-latency mein slot ring, warna pipe
+// capacity: ek message mein max doubles (ring slot ka size)
+void make_link(int capacity, Channel *reader, Channel *writer) {
+    if (low_latency) {
+        SlotRing *ring = create_slot_ring(capacity);
+        *reader = make_ring_channel(ring);
+        *writer = make_ring_channel(ring);
+        return;
     }
-    fprintf(local_result_file, "\n");
-    fflush(local_result_file);
-    pthread_mutex_unlock(&file_lock);
-    
-    printf("  Processing complete\n\n");
-    
-    // Backward pass computation - backpropagation simulate karna
-    printf("[PHASE] BACKWARD PROPAGATION (PID: %d)\n", getpid());
-    printf("  Computing activation functions...\n\n");
-    
-    // Backward data store karne ke liye memory
-    double *backward_data = static_cast<double *>(malloc(num_neurons * sizeof(double)));
-    if (!backward_data) {
-        fprintf(stderr, "ERROR: Memory allocation failed\n");
+    int fds[2];
+    if (pipe(fds) == -1) {
+        perror("pipe");
         exit(1);
     }
-    
-    // Activation functions apply karo: f(x1) aur f(x2)
-    pthread_mutex_lock(&file_lock);
-    fprintf(local_result_file, "BACKWARD PASS COMPUTATION\n");
-    fprintf(local_result_file, "Formula 1: f(x1) = (x^2 + x + 1) / 2\n");
-    fprintf(local_result_file, "Formula 2: f(x2) = (x^2 - x) / 2\n");
-    fprintf(local_result_file, "Results:\n");
-    
-    // Har neuron ke liye formulas apply karo
-    for (int i = 0; i < num_neurons; i++) {
-        double val = output[i];
-        double fx1 = ((val * val) + val + 1.0) / 2.0;  // Formula 1
-        double fx2 = ((val * val) - val) / 2.0;        // Formula 2
-        
-        backward_data[i] = fx1;  // Backward pass ke liye f(x1) use karo
-        fprintf(local_result_file, "  Neuron[%d]: f(x1)=%.6f | f(x2)=%.6f\n", i, fx1, fx2);
+    *reader = make_channel(PIPE_CHANNEL, fds[0]);
+    *writer = make_channel(PIPE_CHANNEL, fds[1]);
+}
+
+// Channel par ek message bhejo
+int channel_send(const Channel *ch, double *data, int count) {
+    if (ch->kind == PIPE_CHANNEL) {
+        return write_to_pipe(ch->fd, data, count);
     }
-    fprintf(local_result_file, "\n");
-    fflush(local_result_file);
-    pthread_mutex_unlock(&file_lock);
-    
-    // Backward data ko pipe se previous layers ko bhejo
-    if (!write_to_pipe(backward_write_fd, backward_data, num_neurons)) {
-        fprintf(stderr, "ERROR: Failed to write backward data\n");
-        exit(1);
+    if (ch->kind == RING_CHANNEL) {
+        return count > 0 && ring_send(ch->ring, data, count);
     }
-    close(backward_write_fd);
-    
-    free(input_data);
-    free(weights);
-    free(output);
-    free(backward_data);
-    fclose(input_fp);
-    fclose(local_result_file);
     
-    printf("  Backward computation complete\n\n");
-    exit(0);
+    // TCP: header aur payload ek saath niklein - cork lagao, likho, cork hatao (flush)
+    FrameHeader header;
+    header.magic = FRAME_MAGIC;
+    header.reserved = 0;
+    header.count = count;
+    int on = 1, off = 0;
+    setsockopt(ch->fd, IPPROTO_TCP, TCP_CORK, &on, sizeof(on));
+    int ok = write_full(ch->fd, &header, sizeof(header)) &&
+             write_full(ch->fd, data, (size_t)count * sizeof(double));
+    setsockopt(ch->fd, IPPROTO_TCP, TCP_CORK, &off, sizeof(off));
+    return ok;
 }
 
-// Second forward pass - input layer
-void second_input_layer_process(int num_neurons, int neurons_per_layer,
-                                int read_backward_fd, int write_fd, int total_hidden_layers) {
-    printf("[PHASE] SECOND FORWARD PASS - INPUT LAYER (PID: %d)\n", getpid());
-    printf("  Using backward outputs as new inputs...\n\n");
-    
-    // Is process ke liye output file kholo (append mode)
-    FILE *local_result_file = fopen("output.txt", "a");
-    if (!local_result_file) {
-        fprintf(stderr, "ERROR: Cannot open output.txt\n");
-        exit(1);
+// Channel se ek message padho - buffer reuse hota hai, chhota pade to bada
+int channel_recv(const Channel *ch, double **buffer, int *capacity, int *count) {
+    if (ch->kind == PIPE_CHANNEL) {
+        return read_from_pipe_into(ch->fd, buffer, capacity, count);
     }
-    
-    // Open input file for this process
-    FILE *input_fp = fopen("input.txt", "r");
-    if (!input_fp) {
-        fprintf(stderr, "ERROR: Cannot open input.txt\n");
-        fclose(local_result_file);
-        exit(1);
+    if (ch->kind == RING_CHANNEL) {
+        return ring_recv(ch->ring, buffer, capacity, count);
     }
     
-    // Skip: input values + input layer weights + all hidden layer weights + output layer weights
-    double dummy;
-    parse_double_with_comma(input_fp, &dummy);
-    parse_double_with_comma(input_fp, &dummy);
-    for (int i = 0; i < INPUT_NEURONS * num_neurons; i++) {
-        parse_double_with_comma(input_fp, &dummy);
+    FrameHeader header;
+    if (!read_full(ch->fd, &header, sizeof(header))) {
+        return 0;  // Upstream ne connection band kiya
     }
-    for (int i = 0; i < total_hidden_layers; i++) {
-        for (int j = 0; j < num_neurons * num_neurons; j++) {
-            parse_double_with_comma(input_fp, &dummy);
+    if (header.magic != FRAME_MAGIC || header.count == 0 || header.count > INT32_MAX) {
+        fprintf(stderr, "ERROR: Invalid frame on socket (PID: %d)\n", getpid());
+        return 0;
+    }
+    int n = (int)header.count;
+    if (n > *capacity) {
+        double *grown = static_cast<double *>(realloc(*buffer, (size_t)n * sizeof(double)));
+        if (!grown) {
+            return 0;  // Memory allocation fail
         }
+        *buffer = grown;
+        *capacity = n;
     }
-    for (int i = 0; i < num_neurons * num_neurons; i++) {
-        parse_double_with_comma(input_fp, &dummy);
+    *count = n;
+    return read_full(ch->fd, *buffer, (size_t)n * sizeof(double));
+}
+
+// Writer side band karo - reader ko EOF milta hai (ring mein EOF ek khali message hai)
+void channel_finish(const Channel *ch) {
+    if (ch->kind == RING_CHANNEL) {
+        ring_send(ch->ring, NULL, 0);
+        return;
     }
-    
-    // Read backward data
-    double *backward_data;
-    int backward_count;
-    if (!read_from_pipe(read_backward_fd, &backward_data, &backward_count)) {
-        fprintf(stderr, "ERROR: Failed to read backward data\n");
-        fclose(input_fp);
-        exit(1);
+    close(ch->fd);
+}
+
+// Is process ko yeh end nahi chahiye - pipe/socket band, ring ki mapping rehne do
+// (usi process mein link ka doosra end use ho raha ho sakta hai)
+void channel_drop(const Channel *ch) {
+    if (ch->kind != RING_CHANNEL) close(ch->fd);
+}
+
+// Chhote frames turant jayein (Nagle band), bade frames ke liye bade socket buffers
+void tune_tcp_socket(int fd) {
+    int on = 1;
+    int buffer_size = 4 * 1024 * 1024;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+}
+
+// Saare interfaces par port sunna shuru karo (port 0 = koi bhi free port)
+int tcp_listen(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
     }
-    close(read_backward_fd);
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
     
-    // Read weights for second pass
-    double *weights = static_cast<double *>(malloc(backward_count * num_neurons * sizeof(double)));
-    for (int i = 0; i < backward_count * num_neurons; i++) {
-        if (!parse_double_with_comma(input_fp, &weights[i])) {
-            fprintf(stderr, "ERROR: Insufficient weight data for second pass\n");
-            fclose(input_fp);
-            exit(1);
-        }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1 ||
+        listen(fd, 4) == -1) {
+        perror("bind/listen");
+        close(fd);
+        return -1;
     }
-    
-    // Process with threads
-    double *output = launch_neuron_threads(num_neurons, backward_count, 
-                                           backward_data, weights);
-    
-    pthread_mutex_lock(&file_lock);
-    fprintf(local_result_file, "FORWARD PASS 2 - LAYER 1 OUTPUT\n");
-    fprintf(local_result_file, "Output:\n");
-    for (int i = 0; i < num_neurons; i++) {
-        fprintf(local_result_file, "  Neuron[%d] = %.6f\n", i, output[i]);
+    return fd;
+}
+
+// Listening socket ka asli port (port 0 se bind kiya ho to)
+int tcp_local_port(int fd) {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    if (getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &len) == -1) {
+        return -1;
     }
-    fprintf(local_result_file, "\n");
-    fflush(local_result_file);
-    pthread_mutex_unlock(&file_lock);
+    return ntohs(addr.sin_port);
+}
+
+int tcp_accept(int listen_fd) {
+    int fd;
+    do {
+        fd = accept(listen_fd, NULL, NULL);
+    } while (fd < 0 && errno == EINTR);
+    if (fd >= 0) tune_tcp_socket(fd);
+    return fd;
+}
+
+// Downstream host se connect karo - woh shayad abhi start ho raha ho, isliye retry
+int tcp_connect_retry(const char *host, int port, int timeout_ms) {
+    char port_text[16];
+    snprintf(port_text, sizeof(port_text), "%d", port);
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
     
-    // Send output through pipe
-    if (!write_to_pipe(write_fd, output, num_neurons)) {
-        fprintf(stderr, "ERROR: Failed to write to pipe\n");
-        exit(1);
+    for (int waited = 0; waited <= timeout_ms; waited += 50) {
+        struct addrinfo *result;
+        if (getaddrinfo(host, port_text, &hints, &result) == 0) {
+            int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+            if (fd >= 0 && connect(fd, result->ai_addr, result->ai_addrlen) == 0) {
+                freeaddrinfo(result);
+                tune_tcp_socket(fd);
+                return fd;
+            }
+            if (fd >= 0) close(fd);
+            freeaddrinfo(result);
+        }
+        usleep(50 * 1000);
     }
-    
-    close(write_fd);
-    free(backward_data);
-    free(weights);
-    free(output);
-    fclose(input_fp);
-    fclose(local_result_file);
-    
-    exit(0);
+    fprintf(stderr, "ERROR: Cannot connect to %s:%d\n", host, port);
+    return -1;
 }
 
-// Second forward pass - hidden layer
-void second_hidden_layer_process(int layer_num, int num_neurons,
-                                 int read_fd, int write_fd, int total_hidden_layers) {
-    // Is process ke liye output file kholo (append mode)
-    FILE *local_result_file = fopen("output.txt", "a");
-    if (!local_result_file) {
-        fprintf(stderr, "ERROR: Cannot open output.txt\n");
-        exit(1);
-    }
+// ========== LIVE METRICS (SHARED MEMORY PAGE) ==========
+// --metrics FILE: main fork se pehle FILE ko MAP_SHARED map karta hai; har layer
+// process (one-shot, pool ya resident) apne stage ke counters wahan lock-free
+// atomics se badhata hai. --top FILE doosre terminal se wahi page read-only map
+// karke har interval ke deltas se rates aur stage utilization dikhata hai -
+// run roke bina ya output.txt parse kiye bina bottleneck stage dikh jata hai.
+
+const uint32_t METRICS_MAGIC = 0x4e4e4d54;   // "NNMT"
+const int DEFAULT_TOP_INTERVAL_MS = 1000;
+
+enum StageState {
+    STAGE_IDLE,         // Abhi shuru nahi hua
+    STAGE_WAITING,      // Input ka intezar
+    STAGE_BUSY,         // Compute + send
+    STAGE_DONE          // Process exit ho gaya
+};
+
+// Har stage ka apna cache line - alag processes ke writes ek doosre ki line invalidate na karein
+struct StageMetrics {
+    alignas(64) int32_t pid;
+    int32_t state;              // StageState
+    uint64_t messages;          // Kitne inputs (batches) process hue
+    uint64_t rows;              // Kitne input vectors
+    uint64_t busy_ns;           // Compute, report aur send mein laga time
+    uint64_t wait_ns;           // Upstream ka intezar
+    uint64_t queued_bytes;      // Aakhri receive ke baad input par kitna data baaki tha
+};
+
+struct MetricsPage {
+    uint32_t magic;
+    int32_t owner_pid;          // Jis process ne page banaya - woh khatam to run khatam
+    int32_t hidden_layers;
+    int32_t neurons_per_layer;
+    int32_t stage_count;
+    StageMetrics stages[MAX_STAGES];
+};
+
+MetricsPage *metrics_page = NULL;   // NULL = metrics band, forked processes inherit karte hain
+
+uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Pipe/socket par kitne bytes padhe jaane baaki hain
+long fd_queued_bytes(int fd) {
+    int pending = 0;
+    if (fd < 0 || ioctl(fd, FIONREAD, &pending) != 0) return 0;
+    return pending;
+}
+
+// Input par kitne bytes pade hain (pipe/socket: FIONREAD, ring: publish hue slots)
+long channel_queued_bytes(const Channel *ch) {
+    if (ch->kind == RING_CHANNEL) {
+        SlotRing *ring = ch->ring;
+        uint32_t head = ring->head;  // Consumer (hum) hi likhte hain
+        uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        long bytes = 0;
+        for (uint32_t m = head; m != tail; m++) {
+            bytes += ring->counts[m % RING_SLOTS] * (long)sizeof(double);
+        }
+        return bytes;
+    }
+    return fd_queued_bytes(ch->fd);
+}
+
+// Fork se pehle metrics file banao aur map karo
+int open_metrics_page(const char *path, int hidden_layers, int neurons) {
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, sizeof(MetricsPage)) != 0) {
+        fprintf(stderr, "ERROR: Cannot create metrics page %s\n", path);
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    void *mem = mmap(NULL, sizeof(MetricsPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // Mapping fd ke bina bhi rehti hai
+    if (mem == MAP_FAILED) {
+        perror("mmap");
+        return 0;
+    }
+    metrics_page = static_cast<MetricsPage *>(mem);
+    metrics_page->owner_pid = getpid();
+    metrics_page->hidden_layers = hidden_layers;
+    metrics_page->neurons_per_layer = neurons;
+    metrics_page->stage_count = 2 * (hidden_layers + 2);
+    __atomic_store_n(&metrics_page->magic, METRICS_MAGIC, __ATOMIC_RELEASE);  // Ab page poora hai
+    return 1;
+}
+
+// Stage process shuru hua - pid aur state publish karo
+void metrics_stage_start(int stage_index) {
+    if (!metrics_page) return;
+    StageMetrics *m = &metrics_page->stages[stage_index];
+    __atomic_store_n(&m->pid, getpid(), __ATOMIC_RELAXED);
+    __atomic_store_n(&m->state, STAGE_WAITING, __ATOMIC_RELEASE);
+}
+
+// Input mil gaya - intezar ka time aur input par baaki data
+void metrics_input_received(int stage_index, uint64_t wait_ns, long queued_bytes) {
+    if (!metrics_page) return;
+    StageMetrics *m = &metrics_page->stages[stage_index];
+    __atomic_fetch_add(&m->wait_ns, wait_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&m->queued_bytes, (uint64_t)queued_bytes, __ATOMIC_RELAXED);
+    __atomic_store_n(&m->state, STAGE_BUSY, __ATOMIC_RELEASE);
+}
+
+// Ek message ka kaam khatam - rows aur busy time
+void metrics_work_done(int stage_index, int rows, uint64_t busy_ns) {
+    if (!metrics_page) return;
+    StageMetrics *m = &metrics_page->stages[stage_index];
+    __atomic_fetch_add(&m->busy_ns, busy_ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->rows, (uint64_t)rows, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->messages, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&m->state, STAGE_WAITING, __ATOMIC_RELEASE);
+}
+
+void metrics_stage_finish(int stage_index) {
+    if (!metrics_page) return;
+    __atomic_store_n(&metrics_page->stages[stage_index].state, STAGE_DONE, __ATOMIC_RELEASE);
+}
+
+// Page ki ek consistent-enough copy (har counter atomic padha jata hai)
+void snapshot_metrics(const MetricsPage *page, MetricsPage *copy) {
+    copy->stage_count = page->stage_count;
+    for (int s = 0; s < page->stage_count; s++) {
+        const StageMetrics *m = &page->stages[s];
+        StageMetrics *c = &copy->stages[s];
+        c->pid = __atomic_load_n(&m->pid, __ATOMIC_RELAXED);
+        c->state = __atomic_load_n(&m->state, __ATOMIC_ACQUIRE);
+        c->messages = __atomic_load_n(&m->messages, __ATOMIC_RELAXED);
+        c->rows = __atomic_load_n(&m->rows, __ATOMIC_RELAXED);
+        c->busy_ns = __atomic_load_n(&m->busy_ns, __ATOMIC_RELAXED);
+        c->wait_ns = __atomic_load_n(&m->wait_ns, __ATOMIC_RELAXED);
+        c->queued_bytes = __atomic_load_n(&m->queued_bytes, __ATOMIC_RELAXED);
+    }
+}
+
+// --top FILE: har interval par stages ki table - owner process khatam hone par
+// aakhri (poori run ki) table print karke exit
+int run_top(const char *path, int interval_ms) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: Cannot open metrics page %s\n", path);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(MetricsPage)) {
+        fprintf(stderr, "ERROR: %s is not a metrics page\n", path);  // Chhoti file map karna SIGBUS deta
+        close(fd);
+        return 1;
+    }
+    void *mem = mmap(NULL, sizeof(MetricsPage), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    const MetricsPage *page = static_cast<const MetricsPage *>(mem);
+    if (__atomic_load_n(&page->magic, __ATOMIC_ACQUIRE) != METRICS_MAGIC ||
+        page->stage_count < 1 || page->stage_count > MAX_STAGES) {
+        fprintf(stderr, "ERROR: %s is not a metrics page\n", path);
+        munmap(mem, sizeof(MetricsPage));
+        return 1;
+    }
+    
+    static const char *state_names[] = { "idle", "waiting", "busy", "done" };
+    int clear_screen = isatty(STDOUT_FILENO);
+    MetricsPage before, after;
+    snapshot_metrics(page, &before);
+    uint64_t start_ns = monotonic_ns(), prev_ns = start_ns;
+    int running = (kill(page->owner_pid, 0) == 0 || errno == EPERM);  // Khatam run: sirf summary
+    
+    while (running) {
+        usleep(interval_ms * 1000);
+        running = (kill(page->owner_pid, 0) == 0 || errno == EPERM);
+        snapshot_metrics(page, &after);
+        uint64_t now_ns = monotonic_ns();
+        double window_s = (now_ns - prev_ns) / 1e9;
+        
+        if (clear_screen) printf("\033[H\033[2J");
+        printf("[TOP] %s | owner PID %d | %d hidden layers x %d neurons | %s\n", path,
+               page->owner_pid, page->hidden_layers, page->neurons_per_layer,
+               running ? "running" : "finished");
+        printf("  %-5s %7s %-7s %10s %9s %6s %6s %10s %12s %10s\n", "stage", "pid", "state",
+               "rows/s", "msgs/s", "busy%", "wait%", "queued B", "total rows", "busy ms");
+        
+        int bottleneck = -1, last_active = -1;
+        double bottleneck_busy = -1, output_rate = 0;
+        for (int s = 0; s < after.stage_count; s++) {
+            const StageMetrics *b = &before.stages[s], *a = &after.stages[s];
+            if (a->pid == 0) {
+                printf("  %5d %7s %-7s\n", s, "-", state_names[STAGE_IDLE]);
+                continue;
+            }
+            // Page doosra process likhta hai - state range mein na ho to index mat karo
+            const char *state = (a->state >= STAGE_IDLE && a->state <= STAGE_DONE) ?
+                                state_names[a->state] : "unknown";
+            double rows_rate = (a->rows - b->rows) / window_s;
+            double busy_pct = (a->busy_ns - b->busy_ns) / 1e7 / window_s;
+            double wait_pct = (a->wait_ns - b->wait_ns) / 1e7 / window_s;
+            printf("  %5d %7d %-7s %10.1f %9.1f %6.1f %6.1f %10lu %12lu %10.2f\n", s, a->pid,
+                   state, rows_rate, (a->messages - b->messages) / window_s,
+                   busy_pct, wait_pct, (unsigned long)a->queued_bytes, (unsigned long)a->rows,
+                   a->busy_ns / 1e6);
+            if (busy_pct > bottleneck_busy) {
+                bottleneck_busy = busy_pct;
+                bottleneck = s;
+            }
+            last_active = s;
+            output_rate = rows_rate;
+        }
+        if (last_active >= 0) {
+            printf("  Pipeline output: %.1f rows/s (stage %d) | Bottleneck: stage %d (busy %.1f%%)\n",
+                   output_rate, last_active, bottleneck, bottleneck_busy);
+        }
+        printf("\n");
+        fflush(stdout);
+        
+        before = after;
+        prev_ns = now_ns;
+    }
+    
+    // Poori run ka summary - har stage ke totals
+    printf("[TOP] Run finished after %.2f s of monitoring. Per-stage totals:\n",
+           (monotonic_ns() - start_ns) / 1e9);
+    for (int s = 0; s < before.stage_count; s++) {
+        const StageMetrics *a = &before.stages[s];
+        if (a->pid == 0) continue;
+        printf("  stage %2d: %lu rows in %lu messages | busy %.2f ms | waited %.2f ms\n", s,
+               (unsigned long)a->rows, (unsigned long)a->messages, a->busy_ns / 1e6,
+               a->wait_ns / 1e6);
+    }
+    munmap(mem, sizeof(MetricsPage));
+    return 0;
+}
+
+// ========== ASYNC FILE I/O (IO_URING / THREAD FALLBACK) ==========
+// Weights bade chunks mein async read hote hain (read-ahead) aur report/binary
+// outputs async write hote hain, taake compute path file I/O par block na ho.
+// io_uring na mile (purana kernel, seccomp) to ek worker thread wahi kaam karta hai.
+
+const int ASYNC_QUEUE_DEPTH = 16;              // Ek AsyncIO mein max in-flight requests
+const size_t ASYNC_READ_CHUNK = 1 << 20;       // Weight file read-ahead chunk (1 MiB)
+const int ASYNC_READAHEAD_CHUNKS = 4;          // Itne chunks aage se read hote rehte hain
+
+enum AsyncBackend {
+    ASYNC_AUTO,             // io_uring mile to woh, warna thread
+    ASYNC_THREAD            // --io-backend threads: hamesha worker thread
+};
+AsyncBackend async_backend = ASYNC_AUTO;       // Global - fork hone wale processes bhi dekhenge
+
+enum AsyncSlotState {
+    SLOT_FREE,
+    SLOT_QUEUED,            // Submit ho gaya, complete nahi hua
+    SLOT_FINISHED,          // (sirf fallback) worker ne kar diya, reap baaki hai
+    SLOT_COMPLETE           // Read complete - async_io_wait_slot ke collect karne tak reserved
+};
+
+// Ek in-flight read/write - short transfers ka baaki hissa dobara submit hota hai
+struct AsyncSlot {
+    AsyncSlotState state;
+    int is_write;
+    int fd;
+    char *buf;
+    size_t len;
+    size_t done;            // Kitne bytes ho chuke (read mein EOF par len se kam)
+    off_t offset;
+    int owns_buf;           // Complete hone par buf free karna hai (writes)
+    struct iovec iov;       // READV/WRITEV ke liye (5.1+ kernels par available)
+};
+
+struct AsyncIO {
+    int use_uring;
+    int errors;             // Fail hui requests - wait par report hoti hain
+    AsyncSlot slots[ASYNC_QUEUE_DEPTH];
+    int in_flight;
+    
+    // io_uring rings (mmap kiye hue)
+    int ring_fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_size, cq_ring_size, sqes_size;
+    
+    // Thread fallback - FIFO order mein worker pread/pwrite karta hai
+    pthread_t worker;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int fifo[ASYNC_QUEUE_DEPTH];
+    int fifo_head, fifo_len;
+    int stopping;
+};
+
+// Positional read/write jab tak poora na ho (fallback aur uring short transfers ke liye)
+ssize_t transfer_at(int is_write, int fd, char *buf, size_t len, off_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = is_write ? pwrite(fd, buf + done, len - done, offset + done)
+                             : pread(fd, buf + done, len - done, offset + done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) break;  // Read mein EOF
+        done += n;
+    }
+    return done;
+}
+
+void *async_worker_thread(void *arg) {
+    AsyncIO *aio = static_cast<AsyncIO *>(arg);
+    pthread_mutex_lock(&aio->lock);
+    while (1) {
+        while (aio->fifo_len == 0 && !aio->stopping) {
+            pthread_cond_wait(&aio->cond, &aio->lock);
+        }
+        if (aio->fifo_len == 0) break;
+        int idx = aio->fifo[aio->fifo_head];
+        pthread_mutex_unlock(&aio->lock);
+        
+        // I/O lock ke bahar - submit karne wala thread isi dauran compute kar sakta hai
+        AsyncSlot *slot = &aio->slots[idx];
+        ssize_t n = transfer_at(slot->is_write, slot->fd, slot->buf, slot->len, slot->offset);
+        
+        pthread_mutex_lock(&aio->lock);
+        aio->fifo_head = (aio->fifo_head + 1) % ASYNC_QUEUE_DEPTH;
+        aio->fifo_len--;
+        if (n < 0 || (slot->is_write && (size_t)n != slot->len)) aio->errors++;
+        slot->done = n < 0 ? 0 : n;
+        slot->state = SLOT_FINISHED;
+        pthread_cond_broadcast(&aio->cond);
+    }
+    pthread_mutex_unlock(&aio->lock);
+    return NULL;
+}
+
+// io_uring ke rings setup karo - fail ho to 0 (caller fallback use karega)
+int async_uring_setup(AsyncIO *aio) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = syscall(__NR_io_uring_setup, ASYNC_QUEUE_DEPTH, &params);
+    if (fd < 0) return 0;
+    
+    aio->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    aio->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    aio->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    aio->sq_ring = mmap(NULL, aio->sq_ring_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    aio->cq_ring = mmap(NULL, aio->cq_ring_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    aio->sqes = static_cast<struct io_uring_sqe *>(
+        mmap(NULL, aio->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+             fd, IORING_OFF_SQES));
+    if (aio->sq_ring == MAP_FAILED || aio->cq_ring == MAP_FAILED || aio->sqes == MAP_FAILED) {
+        if (aio->sq_ring != MAP_FAILED) munmap(aio->sq_ring, aio->sq_ring_size);
+        if (aio->cq_ring != MAP_FAILED) munmap(aio->cq_ring, aio->cq_ring_size);
+        if (aio->sqes != MAP_FAILED) munmap(aio->sqes, aio->sqes_size);
+        close(fd);
+        return 0;
+    }
+    
+    char *sq = static_cast<char *>(aio->sq_ring);
+    char *cq = static_cast<char *>(aio->cq_ring);
+    aio->sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    aio->sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    aio->sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    aio->sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    aio->cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    aio->cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    aio->cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    aio->cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    aio->ring_fd = fd;
+    return 1;
+}
+
+void async_io_init(AsyncIO *aio) {
+    memset(aio, 0, sizeof(*aio));
+    aio->ring_fd = -1;
+    if (async_backend == ASYNC_AUTO && async_uring_setup(aio)) {
+        aio->use_uring = 1;
+        return;
+    }
+    pthread_mutex_init(&aio->lock, NULL);
+    pthread_cond_init(&aio->cond, NULL);
+    if (pthread_create(&aio->worker, NULL, async_worker_thread, aio) != 0) {
+        perror("pthread_create");
+        exit(1);
+    }
+}
+
+// Slot ko ring mein daalo (uring) - short transfer ka baaki hissa bhi yahin se jata hai
+void async_uring_push(AsyncIO *aio, int idx) {
+    AsyncSlot *slot = &aio->slots[idx];
+    unsigned tail = *aio->sq_tail;
+    unsigned index = tail & *aio->sq_mask;
+    struct io_uring_sqe *sqe = &aio->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    slot->iov.iov_base = slot->buf + slot->done;
+    slot->iov.iov_len = slot->len - slot->done;
+    sqe->opcode = slot->is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = slot->fd;
+    sqe->off = slot->offset + slot->done;
+    sqe->addr = reinterpret_cast<unsigned long>(&slot->iov);
+    sqe->len = 1;
+    sqe->user_data = idx;
+    aio->sq_array[index] = index;
+    __atomic_store_n(aio->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    
+    while (syscall(__NR_io_uring_enter, aio->ring_fd, 1, 0, 0, NULL, 0) < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+        perror("io_uring_enter");
+        exit(1);
+    }
+}
+
+// Kam se kam ek completion process karo (block karke)
+void async_reap_one(AsyncIO *aio) {
+    if (!aio->use_uring) {
+        pthread_mutex_lock(&aio->lock);
+        while (1) {
+            for (int i = 0; i < ASYNC_QUEUE_DEPTH; i++) {
+                AsyncSlot *slot = &aio->slots[i];
+                if (slot->state != SLOT_FINISHED) continue;
+                if (slot->owns_buf) free(slot->buf);
+                slot->state = slot->owns_buf ? SLOT_FREE : SLOT_COMPLETE;
+                aio->in_flight--;
+                pthread_mutex_unlock(&aio->lock);
+                return;
+            }
+            pthread_cond_wait(&aio->cond, &aio->lock);
+        }
+    }
+    
+    unsigned head = *aio->cq_head;
+    while (head == __atomic_load_n(aio->cq_tail, __ATOMIC_ACQUIRE)) {
+        if (syscall(__NR_io_uring_enter, aio->ring_fd, 0, 1, IORING_ENTER_GETEVENTS,
+                    NULL, 0) < 0 && errno != EINTR) {
+            perror("io_uring_enter");
+            exit(1);
+        }
+    }
+    struct io_uring_cqe *cqe = &aio->cqes[head & *aio->cq_mask];
+    int idx = static_cast<int>(cqe->user_data);
+    int res = cqe->res;
+    __atomic_store_n(aio->cq_head, head + 1, __ATOMIC_RELEASE);
+    
+    AsyncSlot *slot = &aio->slots[idx];
+    if (res == -EINTR || res == -EAGAIN) {
+        async_uring_push(aio, idx);
+        return;
+    }
+    if (res > 0) {
+        slot->done += res;
+        if (slot->done < slot->len) {
+            async_uring_push(aio, idx);  // Short transfer - baaki hissa
+            return;
+        }
+    } else if (res < 0 || slot->is_write) {
+        aio->errors++;  // Write mein 0 bytes bhi error hai; read mein 0 = EOF
+    }
+    if (slot->owns_buf) free(slot->buf);
+    slot->state = slot->owns_buf ? SLOT_FREE : SLOT_COMPLETE;
+    aio->in_flight--;
+}
+
+// Read/write submit karo - queue bhari ho to ek completion ka wait hota hai
+// owns_buf: complete hone par buf free karna (fire-and-forget writes)
+int async_io_submit(AsyncIO *aio, int is_write, int fd, char *buf, size_t len,
+                    off_t offset, int owns_buf) {
+    while (aio->in_flight == ASYNC_QUEUE_DEPTH) {
+        async_reap_one(aio);
+    }
+    if (!aio->use_uring) pthread_mutex_lock(&aio->lock);
+    int idx = 0;
+    while (idx < ASYNC_QUEUE_DEPTH && aio->slots[idx].state != SLOT_FREE) idx++;
+    if (idx == ASYNC_QUEUE_DEPTH) {
+        // Saare slots un-collected reads ne pakde hue hain - caller ki galti
+        fprintf(stderr, "ERROR: Async I/O queue exhausted\n");
+        exit(1);
+    }
+    AsyncSlot *slot = &aio->slots[idx];
+    slot->state = SLOT_QUEUED;
+    slot->is_write = is_write;
+    slot->fd = fd;
+    slot->buf = buf;
+    slot->len = len;
+    slot->done = 0;
+    slot->offset = offset;
+    slot->owns_buf = owns_buf;
+    aio->in_flight++;
+    
+    if (aio->use_uring) {
+        async_uring_push(aio, idx);
+    } else {
+        aio->fifo[(aio->fifo_head + aio->fifo_len) % ASYNC_QUEUE_DEPTH] = idx;
+        aio->fifo_len++;
+        pthread_cond_broadcast(&aio->cond);
+        pthread_mutex_unlock(&aio->lock);
+    }
+    return idx;
+}
+
+// Ek specific request complete hone tak ruko - read mein kitne bytes aaye woh return
+size_t async_io_wait_slot(AsyncIO *aio, int idx) {
+    while (aio->slots[idx].state != SLOT_COMPLETE) {
+        async_reap_one(aio);
+    }
+    if (!aio->use_uring) pthread_mutex_lock(&aio->lock);
+    aio->slots[idx].state = SLOT_FREE;
+    if (!aio->use_uring) pthread_mutex_unlock(&aio->lock);
+    return aio->slots[idx].done;
+}
+
+// Saari pending requests complete karo - koi fail hui ho to 0
+int async_io_wait_all(AsyncIO *aio) {
+    while (aio->in_flight > 0) {
+        async_reap_one(aio);
+    }
+    int ok = (aio->errors == 0);
+    aio->errors = 0;
+    return ok;
+}
+
+void async_io_destroy(AsyncIO *aio) {
+    async_io_wait_all(aio);
+    if (aio->use_uring) {
+        munmap(aio->sqes, aio->sqes_size);
+        munmap(aio->cq_ring, aio->cq_ring_size);
+        munmap(aio->sq_ring, aio->sq_ring_size);
+        close(aio->ring_fd);
+    } else {
+        pthread_mutex_lock(&aio->lock);
+        aio->stopping = 1;
+        pthread_cond_broadcast(&aio->cond);
+        pthread_mutex_unlock(&aio->lock);
+        pthread_join(aio->worker, NULL);
+        pthread_mutex_destroy(&aio->lock);
+        pthread_cond_destroy(&aio->cond);
+    }
+}
+
+// Weight file ka read-ahead stream - stdio (fopencookie) isi se padhta hai, taake
+// parse_double_with_comma waisa hi rahe aur agle chunks background mein aate rahein
+struct AsyncReader {
+    AsyncIO aio;
+    int fd;
+    off_t next_offset;                         // Agla chunk file mein kahan se
+    off_t end_offset;                          // Is byte se aage nahi padhna (-1 = file end)
+    char *chunks[ASYNC_READAHEAD_CHUNKS];
+    int chunk_slot[ASYNC_READAHEAD_CHUNKS];    // In-flight slot, ya -1 (range khatam)
+    size_t chunk_request[ASYNC_READAHEAD_CHUNKS];  // Kitne bytes mange the
+    int current;                               // Jo chunk abhi parse ho raha hai
+    size_t current_len, current_pos;
+    int eof;
+};
+
+void async_reader_submit(AsyncReader *r, int chunk) {
+    size_t len = ASYNC_READ_CHUNK;
+    if (r->end_offset >= 0) {
+        if (r->next_offset >= r->end_offset) {
+            r->chunk_slot[chunk] = -1;
+            return;
+        }
+        if ((off_t)len > r->end_offset - r->next_offset) len = r->end_offset - r->next_offset;
+    }
+    r->chunk_slot[chunk] = async_io_submit(&r->aio, 0, r->fd, r->chunks[chunk],
+                                           len, r->next_offset, 0);
+    r->chunk_request[chunk] = len;
+    r->next_offset += len;
+}
+
+ssize_t async_reader_read(void *cookie, char *buf, size_t size) {
+    AsyncReader *r = static_cast<AsyncReader *>(cookie);
+    while (r->current_pos == r->current_len) {
+        if (r->eof) return 0;
+        // Pichla chunk khatam - usi buffer mein aage ka chunk mangwao, agle ka wait karo
+        if (r->current >= 0) async_reader_submit(r, r->current);
+        r->current = (r->current + 1) % ASYNC_READAHEAD_CHUNKS;
+        r->current_pos = 0;
+        if (r->chunk_slot[r->current] < 0) {
+            r->eof = 1;  // Range ka end
+            return 0;
+        }
+        r->current_len = async_io_wait_slot(&r->aio, r->chunk_slot[r->current]);
+        if (r->aio.errors) return -1;
+        if (r->current_len < r->chunk_request[r->current]) r->eof = 1;  // File yahin khatam
+        if (r->current_len == 0) return 0;
+    }
+    size_t n = r->current_len - r->current_pos;
+    if (n > size) n = size;
+    memcpy(buf, r->chunks[r->current] + r->current_pos, n);
+    r->current_pos += n;
+    return n;
+}
+
+int async_reader_close(void *cookie) {
+    AsyncReader *r = static_cast<AsyncReader *>(cookie);
+    async_io_destroy(&r->aio);  // Bache hue read-ahead chunks ka wait
+    for (int i = 0; i < ASYNC_READAHEAD_CHUNKS; i++) free(r->chunks[i]);
+    close(r->fd);
+    free(r);
+    return 0;
+}
+
+// fopen(path, "r") jaisa - lekin reads bade async chunks mein, aage se
+// Sirf [begin, end) bytes padhe jaate hain (end = -1: file ke end tak)
+FILE *open_async_reader(const char *path, off_t begin, off_t end) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    posix_fadvise(fd, begin, end < 0 ? 0 : end - begin, POSIX_FADV_SEQUENTIAL);
+    
+    AsyncReader *r = static_cast<AsyncReader *>(calloc(1, sizeof(AsyncReader)));
+    if (!r) {
+        close(fd);
+        return NULL;
+    }
+    r->fd = fd;
+    r->next_offset = begin;
+    r->end_offset = end;
+    r->current = -1;
+    async_io_init(&r->aio);
+    for (int i = 0; i < ASYNC_READAHEAD_CHUNKS; i++) {
+        r->chunks[i] = static_cast<char *>(malloc(ASYNC_READ_CHUNK));
+        if (!r->chunks[i]) {
+            fprintf(stderr, "ERROR: Memory allocation failed\n");
+            exit(1);
+        }
+        async_reader_submit(r, i);
+    }
+    
+    cookie_io_functions_t io = {async_reader_read, NULL, NULL, async_reader_close};
+    FILE *fp = fopencookie(r, "r", io);
+    if (!fp) async_reader_close(r);
+    return fp;
+}
+
+// Report section - pehle memory mein format hota hai (open_memstream), phir ek
+// async positional write se output.txt mein jata hai
+struct ReportSection {
+    FILE *fp;
+    char *text;
+    size_t len;
+};
+
+// Report mein agla likhne ka offset - sab layer processes share karte hain (MAP_SHARED).
+// Har stage apna range upstream se data milne ke baad aur downstream ko bhejne se pehle
+// reserve karta hai, isliye order pipeline jaisa hi rehta hai chahe writes kisi bhi
+// order mein complete hon.
+struct ReportCursor {
+    uint64_t next_offset;
+};
+
+ReportCursor *report_cursor = NULL;
+
+FILE *begin_report_section(ReportSection *section) {
+    section->text = NULL;
+    section->len = 0;
+    section->fp = open_memstream(&section->text, &section->len);
+    if (!section->fp) {
+        fprintf(stderr, "ERROR: Memory allocation failed\n");
+        exit(1);
+    }
+    return section->fp;
+}
+
+// Section ko report file ke agle range mein async likho (text aio free karega)
+void submit_report_section(AsyncIO *aio, int report_fd, ReportSection *section) {
+    fclose(section->fp);
+    uint64_t offset = __atomic_fetch_add(&report_cursor->next_offset, section->len,
+                                         __ATOMIC_SEQ_CST);
+    async_io_submit(aio, 1, report_fd, section->text, section->len, offset, 1);
+}
+
+// ========== EXECUTION PLAN ==========
+// Topology aur input.txt se plan ek hi baar banta hai (main mein, fork se pehle):
+// har stage ka shape, weights ka byte range, kernel aur activation buffer. Layer
+// processes fork ke saath plan inherit karte hain - input.txt mein apni position
+// dhundne ke liye kisi ko pichli layers skip nahi karni padti.
+
+const size_t ACTIVATION_ALIGNMENT = 64;   // Cache line (aur vector loads) ke hisaab se
+
+struct PlanStage {
+    int input_size;          // Har input vector ki width
+    int num_neurons;         // Output width
+    int applies_backward;    // Pass 1 output layer ke baad f(x1) lagana hai
+    off_t weight_begin;      // input.txt mein pehle weight ka byte
+    off_t weight_end;        // Aakhri weight ke baad ka byte
+    StageKernel kernel;
+    size_t weight_count;     // Kernel ke layout mein weights (panels ki padding samet)
+    off_t cache_offset;      // --weight-cache file mein is stage ke weights kahan hain
+    int input_buffer;        // Ping-pong: input kis activation buffer mein (0/1)
+    int output_buffer;       // Output hamesha doosre mein
+};
+
+struct ExecutionPlan {
+    int hidden_layers;
+    int neurons_per_layer;
+    int stage_count;                    // 2 * (hidden_layers + 2)
+    int max_width;                      // Sabse chaudi activation - dono buffers isi size ke
+    double input_values[INPUT_NEURONS]; // input.txt ki pehli line
+    off_t weight_cache_size;            // --weight-cache file ka poora size
+    double *activations[2];             // Ping-pong pair - MAP_SHARED, saare layer processes ka
+    PlanStage stages[MAX_STAGES];
+};
+
+ExecutionPlan execution_plan;   // main banata hai, forked processes inherit karte hain
+
+const char *stage_kernel_name(StageKernel kernel) {
+    return kernel == KERNEL_SPLIT_K ? "split-k" : "neuron-threads";
+}
+
+// input.txt ko ek baar scan karke plan banao - values sirf tokens ki tarah gini jaati
+// hain (parse_double_with_comma wale separators), sirf input values parse hoti hain
+int build_execution_plan(const char *path, int hidden_layers, int neurons, ExecutionPlan *plan) {
+    plan->hidden_layers = hidden_layers;
+    plan->neurons_per_layer = neurons;
+    plan->stage_count = 2 * (hidden_layers + 2);
+    plan->max_width = neurons > INPUT_NEURONS ? neurons : INPUT_NEURONS;
+    
+    // Har stage ke pehle aur aakhri weight ka value index
+    long first_value[MAX_STAGES], last_value[MAX_STAGES];
+    long next_value = INPUT_NEURONS;
+    off_t cache_offset = WEIGHT_ALIGNMENT;  // Weight cache ka pehla block header hai
+    for (int s = 0; s < plan->stage_count; s++) {
+        PlanStage *stage = &plan->stages[s];
+        stage->input_size = (s == 0) ? INPUT_NEURONS : neurons;
+        stage->num_neurons = neurons;
+        stage->applies_backward = (s == hidden_layers + 1);
+        stage->kernel = choose_stage_kernel(stage->input_size);
+        stage->weight_count = stage_weight_count(stage->kernel, neurons, stage->input_size);
+        stage->cache_offset = cache_offset;
+        cache_offset += (stage->weight_count * sizeof(double) + WEIGHT_ALIGNMENT - 1) /
+                        WEIGHT_ALIGNMENT * WEIGHT_ALIGNMENT;
+        stage->input_buffer = s % 2;
+        stage->output_buffer = 1 - s % 2;
+        first_value[s] = next_value;
+        next_value += (long)stage->input_size * neurons;
+        last_value[s] = next_value - 1;
+    }
+    plan->weight_cache_size = cache_offset;
+    
+    // Ek hi ping-pong pair poori network ke liye - fork se pehle shared map, taake depth
+    // kitni bhi ho activations ki memory 2 x max_width rahe. One-shot aur pool mein ek
+    // vector stage-by-stage chalta hai: stage s apna output bhej deta hai, tabhi stage s+1
+    // us buffer mein padhta hai aur doosre mein likhta hai - do stages ek saath nahi likhte.
+    size_t buffer_bytes = (plan->max_width * sizeof(double) + ACTIVATION_ALIGNMENT - 1) /
+                          ACTIVATION_ALIGNMENT * ACTIVATION_ALIGNMENT;
+    void *buffers = mmap(NULL, 2 * buffer_bytes, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (buffers == MAP_FAILED) {
+        perror("mmap");
+        return 0;
+    }
+    plan->activations[0] = static_cast<double *>(buffers);
+    plan->activations[1] = reinterpret_cast<double *>(static_cast<char *>(buffers) + buffer_bytes);
+    
+    FILE *fp = open_async_reader(path, 0, -1);
+    if (!fp) {
+        fprintf(stderr, "ERROR: Cannot open %s\n", path);
+        return 0;
+    }
+    off_t offset = 0;
+    long value = 0;
+    int in_value = 0, stage = 0;
+    char text[64];
+    size_t text_len = 0;
+    while (stage < plan->stage_count) {
+        int c = getc_unlocked(fp);
+        int separator = (c == EOF || c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',');
+        if (!separator) {
+            if (!in_value) {
+                in_value = 1;
+                text_len = 0;
+                if (value == first_value[stage]) plan->stages[stage].weight_begin = offset;
+            }
+            if (value < INPUT_NEURONS && text_len < sizeof(text) - 1) text[text_len++] = c;
+        } else if (in_value) {
+            // Value yahin khatam hui
+            in_value = 0;
+            if (value < INPUT_NEURONS) {
+                text[text_len] = '\0';
+                char *end;
+                plan->input_values[value] = strtod(text, &end);
+                if (end == text) {
+                    fprintf(stderr, "ERROR: Failed to read initial input values\n");
+                    fclose(fp);
+                    return 0;
+                }
+            }
+            if (value == last_value[stage]) plan->stages[stage++].weight_end = offset;
+            value++;
+        }
+        if (c == EOF) break;
+        offset++;
+    }
+    fclose(fp);
+    
+    if (value < INPUT_NEURONS) {
+        fprintf(stderr, "ERROR: Failed to read initial input values\n");
+        return 0;
+    }
+    // Weights kam hon to bhi plan poora - baaki stages ka range file ke end par khatam
+    // (ya khali) hota hai, aur woh layer process purane tareeke se "Insufficient weight
+    // data" par fail hota hai; usse pehle ke stages (jaise sirf pass 1) normal chalte hain
+    for (int s = stage; s < plan->stage_count; s++) {
+        if (value <= first_value[s]) plan->stages[s].weight_begin = offset;
+        plan->stages[s].weight_end = offset;
+    }
+    return 1;
+}
+
+// --show-plan ke liye - har stage ki ek line
+void print_execution_plan(const ExecutionPlan *plan) {
+    printf("EXECUTION PLAN (%d stages, shared activation buffers 2 x %d doubles)\n",
+           plan->stage_count, plan->max_width);
+    for (int s = 0; s < plan->stage_count; s++) {
+        const PlanStage *stage = &plan->stages[s];
+        printf("  stage %2d: %3d x %3d | weights bytes %ld-%ld | %-14s | %-6s | buf %d -> %d%s\n",
+               s, stage->num_neurons, stage->input_size, (long)stage->weight_begin,
+               (long)stage->weight_end, stage_kernel_name(stage->kernel),
+               stage->kernel == KERNEL_SPLIT_K ? "rows" : "panels",
+               stage->input_buffer, stage->output_buffer,
+               stage->applies_backward ? " | backward" : "");
+    }
+}
+
+// ========== PACKED WEIGHT CACHE ==========
+// --weight-cache FILE: har stage ke weights kernel ke layout mein (panels ya rows)
+// binary file mein. File valid ho to layer processes text parse aur packing dono
+// chhod kar apna byte range seedha padh lete hain. Valid na ho to main nayi file
+// banata hai, har stage packing ke baad apne offset par likhta hai, aur sab stages
+// safal hone par hi main header ko complete mark karta hai.
+
+const char WEIGHT_CACHE_MAGIC[8] = {'N', 'N', 'P', 'A', 'N', 'E', 'L', '1'};
+
+// Header - file ka pehla WEIGHT_ALIGNMENT block, stages uske baad plan ke offsets par
+struct WeightCacheHeader {
+    char magic[8];
+    uint32_t complete;          // Saare stages likhe ja chuke - tabhi padhna hai
+    int32_t hidden_layers;
+    int32_t neurons_per_layer;
+    int32_t panel_width;
+    uint64_t source_size;       // input.txt ka size, mtime aur inode - badle to cache purana
+    uint64_t source_mtime_ns;
+    uint64_t source_inode;
+    uint64_t packed_stages;     // Kaunse stages panels mein hain (bitmask, kernel choice se)
+};
+
+const char *weight_cache_path = NULL;   // --weight-cache FILE (NULL = band)
+int weight_cache_fd = -1;       // -1 = cache band
+int weight_cache_ready = 0;     // 1 = stages cache se padho, 0 = parse karke cache mein likho
+
+// input.txt aur plan se expected header
+int describe_weight_cache(const char *source, const ExecutionPlan *plan, WeightCacheHeader *header) {
+    struct stat st;
+    if (stat(source, &st) != 0) return 0;
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, WEIGHT_CACHE_MAGIC, sizeof(header->magic));
+    header->hidden_layers = plan->hidden_layers;
+    header->neurons_per_layer = plan->neurons_per_layer;
+    header->panel_width = PANEL_WIDTH;
+    header->source_size = st.st_size;
+    header->source_mtime_ns = (uint64_t)st.st_mtim.tv_sec * 1000000000ULL + st.st_mtim.tv_nsec;
+    header->source_inode = st.st_ino;
+    for (int s = 0; s < plan->stage_count; s++) {
+        if (plan->stages[s].kernel == KERNEL_NEURON_THREADS) header->packed_stages |= 1ULL << s;
+    }
+    return 1;
+}
+
+// Fork se pehle - valid cache kholo ya naya (incomplete) banao
+// Cache na khul sake to sirf warning, simulation bina cache ke chalti hai
+void open_weight_cache(const char *source, const ExecutionPlan *plan) {
+    const char *path = weight_cache_path;
+    WeightCacheHeader expected, found;
+    if (!path || !describe_weight_cache(source, plan, &expected)) return;
+    
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        if (transfer_at(0, fd, reinterpret_cast<char *>(&found), sizeof(found), 0) ==
+                (ssize_t)sizeof(found) && found.complete) {
+            found.complete = 0;
+            if (memcmp(&found, &expected, sizeof(found)) == 0) {
+                weight_cache_fd = fd;
+                weight_cache_ready = 1;
+                return;
+            }
+        }
+        close(fd);
+    }
+    
+    // Purana ya nahi hai - naya banao, stages likhne ke baad complete hoga
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, plan->weight_cache_size) != 0 ||
+        transfer_at(1, fd, reinterpret_cast<char *>(&expected), sizeof(expected), 0) !=
+            (ssize_t)sizeof(expected)) {
+        fprintf(stderr, "WARNING: Could not create weight cache %s\n", path);
+        if (fd >= 0) close(fd);
+        return;
+    }
+    weight_cache_fd = fd;
+    weight_cache_ready = 0;
+}
+
+// Saare stages load hone ke baad (all_loaded = sab safal) - naya cache complete mark karo
+void finish_weight_cache(int all_loaded) {
+    if (weight_cache_fd < 0) return;
+    if (!weight_cache_ready && all_loaded) {
+        uint32_t complete = 1;
+        if (fdatasync(weight_cache_fd) != 0 ||
+            transfer_at(1, weight_cache_fd, reinterpret_cast<char *>(&complete), sizeof(complete),
+                        offsetof(WeightCacheHeader, complete)) != (ssize_t)sizeof(complete)) {
+            fprintf(stderr, "WARNING: Could not finish weight cache\n");
+        }
+    }
+    close(weight_cache_fd);
+    weight_cache_fd = -1;
+    weight_cache_ready = 0;
+}
+
+// Stage ke weights kernel ke layout mein - cache ready ho to wahan se, warna fp
+// (stage ke byte range par khula reader) se parse karke pack karo
+// Weights kam padein to NULL
+double *load_stage_weights(FILE *fp, const PlanStage *stage) {
+    size_t bytes = stage->weight_count * sizeof(double);
+    double *weights = alloc_weight_buffer(stage->weight_count);
+    if (weight_cache_ready) {
+        if (transfer_at(0, weight_cache_fd, reinterpret_cast<char *>(weights), bytes,
+                        stage->cache_offset) != (ssize_t)bytes) {
+            free(weights);
+            return NULL;
+        }
+        return weights;
+    }
+    
+    int row_count = stage->input_size * stage->num_neurons;
+    for (int i = 0; i < row_count; i++) {
+        if (!parse_double_with_comma(fp, &weights[i])) {
+            free(weights);
+            return NULL;
+        }
+    }
+    if (stage->kernel == KERNEL_NEURON_THREADS) {
+        double *packed = pack_weight_panels(weights, stage->num_neurons, stage->input_size);
+        free(weights);
+        weights = packed;
+    }
+    
+    if (weight_cache_fd >= 0 &&
+        transfer_at(1, weight_cache_fd, reinterpret_cast<char *>(weights), bytes,
+                    stage->cache_offset) != (ssize_t)bytes) {
+        // Magic mita do - main complete mark kare tab bhi agli run file ko purana maanegi
+        char invalid[sizeof(WEIGHT_CACHE_MAGIC)] = {0};
+        transfer_at(1, weight_cache_fd, invalid, sizeof(invalid), 0);
+        fprintf(stderr, "WARNING: Could not write weight cache\n");
+    }
+    return weights;
+}
+
+// Backward pass ka formula f(x1) = (x^2 + x + 1) / 2 - in place lagao
+void apply_backward_formula(double *values, int count) {
+    for (int i = 0; i < count; i++) {
+        double val = values[i];
+        values[i] = ((val * val) + val + 1.0) / 2.0;
+    }
+}
+
+// ========== INCREMENTAL RECOMPUTATION (CHECKPOINT) ==========
+// --incremental ke saath har stage apna output aur fingerprints checkpoint file
+// mein rakhta hai. Agli run mein main fork se pehle har stage ke weights ke raw bytes
+// ka fingerprint leta hai; shuruati stages jinke weights aur input dono same hon unke
+// liye na process fork hota hai na weights parse hote hain - main unka report checkpoint
+// se replay karta hai aur chain pehle badle hue stage se shuru hoti hai.
+
+const char *CHECKPOINT_FILE = "activations.ckpt";
+const uint32_t CHECKPOINT_MAGIC = 0x4e4e434b;   // "NNCK"
+
+// Ek stage ka saved result
+struct StageCheckpoint {
+    int valid;
+    int reused;                     // Is run mein checkpoint se liya gaya (report ke liye)
+    int output_count;
+    uint64_t weights_fingerprint;   // Is stage ke weights ka hash
+    uint64_t input_fingerprint;     // Is stage ke input vector ka hash
+    double outputs[MAX_NEURONS];
+};
+
+// Poori network ka checkpoint - fork se pehle shared memory mein rakha jata hai
+// taake har layer process apni entry padh aur update kar sake
+struct ActivationCheckpoint {
+    uint32_t magic;
+    int hidden_layers;
+    int neurons_per_layer;
+    StageCheckpoint stages[MAX_STAGES];
+};
+
+ActivationCheckpoint *checkpoint = NULL;   // NULL = incremental mode band
+
+// Shared checkpoint banao aur purani file ho (same configuration) to load karo
+int open_checkpoint(int hidden_layers, int neurons) {
+    void *mem = mmap(NULL, sizeof(ActivationCheckpoint), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap");
+        return 0;
+    }
+    checkpoint = static_cast<ActivationCheckpoint *>(mem);
+    
+    FILE *fp = fopen(CHECKPOINT_FILE, "rb");
+    int loaded = fp && fread(checkpoint, sizeof(ActivationCheckpoint), 1, fp) == 1 &&
+                 checkpoint->magic == CHECKPOINT_MAGIC &&
+                 checkpoint->hidden_layers == hidden_layers &&
+                 checkpoint->neurons_per_layer == neurons;
+    if (fp) fclose(fp);
+    
+    if (!loaded) {
+        // Configuration badli ya pehli run - sab kuch compute hoga
+        memset(checkpoint, 0, sizeof(ActivationCheckpoint));
+        checkpoint->magic = CHECKPOINT_MAGIC;
+        checkpoint->hidden_layers = hidden_layers;
+        checkpoint->neurons_per_layer = neurons;
+    }
+    for (int s = 0; s < MAX_STAGES; s++) {
+        checkpoint->stages[s].reused = 0;
+    }
+    return 1;
+}
+
+// Saare processes khatam hone ke baad checkpoint file update karo
+void save_checkpoint(int stage_count) {
+    int reused = 0, first_computed = -1;
+    for (int s = 0; s < stage_count; s++) {
+        if (checkpoint->stages[s].reused) reused++;
+        else if (first_computed < 0) first_computed = s;
+    }
+    
+    FILE *fp = fopen(CHECKPOINT_FILE, "wb");
+    if (!fp || fwrite(checkpoint, sizeof(ActivationCheckpoint), 1, fp) != 1) {
+        fprintf(stderr, "WARNING: Could not write %s\n", CHECKPOINT_FILE);
+    }
+    if (fp) fclose(fp);
+    
+    printf("[INCREMENTAL] Reused %d of %d stages", reused, stage_count);
+    if (first_computed >= 0) printf(", recomputed from stage %d\n\n", first_computed);
+    else printf(" (nothing changed)\n\n");
+    
+    munmap(checkpoint, sizeof(ActivationCheckpoint));
+    checkpoint = NULL;
+}
+
+// input.txt mein har stage ke weights ke raw bytes ka fingerprint - main fork se pehle
+// bharta hai, weights parse kiye bina (byte ranges plan mein hain)
+uint64_t stage_weight_fingerprints[MAX_STAGES];
+
+// Plan ke byte ranges se saare stages ke fingerprints nikalo
+int fingerprint_stage_weights(const char *path, const ExecutionPlan *plan) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: Cannot open %s\n", path);
+        return 0;
+    }
+    char *bytes = NULL;
+    size_t capacity = 0;
+    for (int s = 0; s < plan->stage_count; s++) {
+        const PlanStage *stage = &plan->stages[s];
+        size_t len = stage->weight_end - stage->weight_begin;
+        if (len > capacity) {
+            char *grown = static_cast<char *>(realloc(bytes, len));
+            if (!grown) {
+                fprintf(stderr, "ERROR: Memory allocation failed\n");
+                exit(1);
+            }
+            bytes = grown;
+            capacity = len;
+        }
+        if (transfer_at(0, fd, bytes, len, stage->weight_begin) != (ssize_t)len) {
+            fprintf(stderr, "ERROR: Failed to read weights of stage %d\n", s);
+            free(bytes);
+            close(fd);
+            return 0;
+        }
+        // Reduction order bhi shamil - split-K aur sequential ke outputs last bits mein alag
+        uint64_t h = (s ^ reduction_signature()) ^ 1469598103934665603ULL;
+        for (size_t i = 0; i < len; i++) {
+            h ^= (unsigned char)bytes[i];
+            h *= 1099511628211ULL;
+        }
+        stage_weight_fingerprints[s] = h;
+    }
+    free(bytes);
+    close(fd);
+    return 1;
+}
+
+// Fork se pehle - checkpoint ke saath kitne shuruati stages bilkul nahi badle
+// Stage s tab reuse hota hai jab uske weights ke bytes aur uska input dono same hon;
+// input pichle reused stage ke saved output se banta hai (backward stage ke baad f(x1)).
+// Return: pehla stage jo compute hoga (stage_count = kuch nahi badla)
+int find_incremental_resume_stage(const ExecutionPlan *plan) {
+    double input[MAX_NEURONS];
+    memcpy(input, plan->input_values, sizeof(plan->input_values));
+    for (int s = 0; s < plan->stage_count; s++) {
+        const PlanStage *stage = &plan->stages[s];
+        StageCheckpoint *saved = &checkpoint->stages[s];
+        if (!saved->valid || saved->output_count != stage->num_neurons ||
+            saved->weights_fingerprint != stage_weight_fingerprints[s] ||
+            saved->input_fingerprint != hash_doubles(input, stage->input_size, s)) {
+            return s;
+        }
+        saved->reused = 1;
+        memcpy(input, saved->outputs, stage->num_neurons * sizeof(double));
+        if (stage->applies_backward) apply_backward_formula(input, stage->num_neurons);
+    }
+    return plan->stage_count;
+}
+
+// Layer output compute karo - ya checkpoint se lo (find_incremental_resume_stage ne
+// stage ko reused mark kiya ho to; aise stages main replay karta hai, weights NULL hote hain)
+// stage_index: 0 = input layer, ..., 2 * (hidden_layers + 2) - 1 = second output layer
+// output: plan ka activation buffer (stage->num_neurons wide)
+void compute_layer_output(int stage_index, const PlanStage *stage, double *input_data,
+                          double *weights, double *output) {
+    int num_neurons = stage->num_neurons;
+    int input_size = stage->input_size;
+    StageCheckpoint *saved = checkpoint ? &checkpoint->stages[stage_index] : NULL;
+    if (saved && saved->reused) {
+        memcpy(output, saved->outputs, num_neurons * sizeof(double));
+        printf("  Weights and inputs unchanged - reusing checkpointed activations\n");
+        return;
+    }
+    
+    launch_stage_kernel(stage->kernel, num_neurons, input_size, 1, input_data, weights, output);
+    if (!saved) return;
+    saved->valid = 1;
+    saved->output_count = num_neurons;
+    saved->weights_fingerprint = stage_weight_fingerprints[stage_index];
+    saved->input_fingerprint = hash_doubles(input_data, input_size, stage_index);
+    memcpy(saved->outputs, output, num_neurons * sizeof(double));
+}
+
+// ========== WEIGHT PREFETCH ==========
+// Har layer process apne weights ek alag thread mein parse karta hai jab tak
+// woh pipe par upstream layer ke output ka wait kar raha hota hai.
+
+struct WeightPrefetch {
+    pthread_t tid;
+    const PlanStage *stage; // Plan se weights ka byte range aur count
+    double *weights;
+    int ok;                 // Saare weights mil gaye to 1
+};
+
+// Prefetch thread - plan ke byte range se sirf is layer ke weights padho, parse
+// aur pack karo (weight cache ready ho to seedha cache se)
+void *prefetch_weights_task(void *params) {
+    WeightPrefetch *pf = static_cast<WeightPrefetch *>(params);
+    const PlanStage *stage = pf->stage;
+    FILE *input_fp = NULL;
+    if (!weight_cache_ready) {
+        input_fp = open_async_reader("input.txt", stage->weight_begin, stage->weight_end);
+        if (!input_fp) {
+            fprintf(stderr, "ERROR: Cannot open input.txt\n");
+            return NULL;
+        }
+    }
+    
+    pf->weights = load_stage_weights(input_fp, stage);
+    pf->ok = (pf->weights != NULL);
+    if (input_fp) fclose(input_fp);
+    return NULL;
+}
+
+void start_weight_prefetch(WeightPrefetch *pf, const PlanStage *stage) {
+    pf->stage = stage;
+    pf->weights = NULL;
+    pf->ok = 0;
+    if (pthread_create(&pf->tid, NULL, prefetch_weights_task, pf) != 0) {
+        perror("pthread_create");
+        exit(1);
+    }
+}
+
+// Prefetch thread ka wait karo - weights na milein to NULL
+double *finish_weight_prefetch(WeightPrefetch *pf) {
+    pthread_join(pf->tid, NULL);
+    if (!pf->ok) {
+        free(pf->weights);
+        return NULL;
+    }
+    return pf->weights;
+}
+
+// Layer ka kind - report ka format aur pipe wiring isi se decide hote hain
+enum LayerKind {
+    INPUT_LAYER,
+    HIDDEN_LAYER,
+    OUTPUT_LAYER
+};
+
+// Ek layer process ko kya karna hai - dono forward passes isi se chalte hain
+struct LayerProcessSpec {
+    int pass;               // 1 = pehla forward pass, 2 = doosra
+    LayerKind kind;
+    int layer_num;          // Report/console ke liye layer number
+    int stage_index;        // input.txt aur checkpoint mein stage ki position
+    int num_neurons;
+    int read_fd;            // Previous layer ya backward pipe (pass 1 input layer: -1)
+    int write_fd;           // Next layer ya backward pipe (pass 2 output layer: -1)
+};
+
+// Layer ka result report section mein likho - format har pass/kind ka purana wala hi hai
+void write_layer_report(FILE *fp, const LayerProcessSpec *spec,
+                        const double *input_values, const double *output) {
+    const char *label = (spec->kind == OUTPUT_LAYER) ? "Output" : "Neuron";
+    
+    if (spec->pass == 1) {
+        if (spec->kind == INPUT_LAYER) {
+            fprintf(fp, "FORWARD PASS 1 - INPUT LAYER COMPUTATION\n");
+            fprintf(fp, "Input: [%.6f, %.6f]\n", input_values[0], input_values[1]);
+        } else if (spec->kind == HIDDEN_LAYER) {
+            fprintf(fp, "FORWARD PASS 1 - HIDDEN LAYER %d COMPUTATION\n", spec->layer_num);
+        } else {
+            fprintf(fp, "FORWARD PASS 1 - OUTPUT LAYER COMPUTATION\n");
+        }
+        fprintf(fp, "Output:\n");
+    } else if (spec->kind == OUTPUT_LAYER) {
+        fprintf(fp, "FORWARD PASS 2 - FINAL OUTPUT LAYER\n");
+        fprintf(fp, "Final Output:\n");
+    } else {
+        // Second pass ki input layer bhi "LAYER 1" hai aur pehli hidden layer bhi
+        fprintf(fp, "FORWARD PASS 2 - LAYER %d OUTPUT\n",
+                spec->kind == INPUT_LAYER ? 1 : spec->layer_num);
+        fprintf(fp, "Output:\n");
+    }
+    for (int i = 0; i < spec->num_neurons; i++) {
+        fprintf(fp, "  %s[%d] = %.6f\n", label, i, output[i]);
+    }
+    fprintf(fp, "\n");
+    if (spec->pass == 2 && spec->kind == OUTPUT_LAYER) {
+        fprintf(fp, "SIMULATION COMPLETED SUCCESSFULLY\n");
+    }
+}
+
+// Backward pass computation - output layer ke results par dono formulas lagao
+// f(x1) agle pass ka input banta hai, f(x2) sirf report mein jata hai
+// backward_data: f(x1) yahan likha jata hai (layer ka khali ping-pong buffer)
+void backward_pass(FILE *fp, const double *output, int num_neurons, double *backward_data) {
+    printf("[PHASE] BACKWARD PROPAGATION (PID: %d)\n", getpid());
+    printf("  Computing activation functions...\n\n");
+    
+    memcpy(backward_data, output, num_neurons * sizeof(double));
+    apply_backward_formula(backward_data, num_neurons);
+    
+    fprintf(fp, "BACKWARD PASS COMPUTATION\n");
+    fprintf(fp, "Formula 1: f(x1) = (x^2 + x + 1) / 2\n");
+    fprintf(fp, "Formula 2: f(x2) = (x^2 - x) / 2\n");
+    fprintf(fp, "Results:\n");
+    for (int i = 0; i < num_neurons; i++) {
+        double val = output[i];
+        double fx2 = ((val * val) - val) / 2.0;        // Formula 2
+        fprintf(fp, "  Neuron[%d]: f(x1)=%.6f | f(x2)=%.6f\n", i, backward_data[i], fx2);
+    }
+    fprintf(fp, "\n");
+}
+
+// Layer start hone par console banner - pass aur kind ke hisaab se
+void print_layer_banner(const LayerProcessSpec *spec) {
+    if (spec->pass == 1 && spec->kind == INPUT_LAYER) {
+        printf("[LAYER %d] INPUT LAYER (PID: %d)\n", spec->layer_num, getpid());
+        printf("  Input neurons: %d\n", INPUT_NEURONS);
+    } else if (spec->pass == 1) {
+        printf("[LAYER %d] %s LAYER (PID: %d)\n", spec->layer_num,
+               spec->kind == HIDDEN_LAYER ? "HIDDEN" : "OUTPUT", getpid());
+        printf("  Neurons: %d\n", spec->num_neurons);
+    } else if (spec->kind == INPUT_LAYER) {
+        printf("[PHASE] SECOND FORWARD PASS - INPUT LAYER (PID: %d)\n", getpid());
+        printf("  Using backward outputs as new inputs...\n\n");
+    }
+}
+
+// Layer ka input activation buffer mein lo - pehli layer plan se, baaki upstream pipe se
+// input_data: plan ka shared activation buffer - count check ke baad hi usmein padhte hain
+void receive_layer_input(const LayerProcessSpec *spec, const PlanStage *stage, double *input_data) {
+    int input_count;
+    uint64_t wait_start = monotonic_ns();
+    const char *source = spec->pass == 2 && spec->kind == INPUT_LAYER ? "backward data" : "from pipe";
+    if (spec->read_fd < 0) {
+        // Pehli layer - input values plan mein hain (input.txt ki pehli line)
+        input_count = INPUT_NEURONS;
+        memcpy(input_data, execution_plan.input_values, INPUT_NEURONS * sizeof(double));
+        printf("  Values: [%.4f, %.4f]\n", input_data[0], input_data[1]);
+    } else if (!read_full(spec->read_fd, &input_count, sizeof(int))) {
+        // Previous layer (ya backward pass) se pipe se input receive karo (IPC)
+        fprintf(stderr, "ERROR: Failed to read %s\n", source);
+        exit(1);
+    }
+    if (input_count != stage->input_size) {
+        fprintf(stderr, "ERROR: Layer expected %d inputs, received %d\n",
+                stage->input_size, input_count);
+        exit(1);
+    }
+    if (spec->read_fd >= 0 &&
+        !read_full(spec->read_fd, input_data, input_count * sizeof(double))) {
+        fprintf(stderr, "ERROR: Failed to read %s\n", source);
+        exit(1);
+    }
+    metrics_input_received(spec->stage_index, monotonic_ns() - wait_start,
+                           fd_queued_bytes(spec->read_fd));
+}
+
+// Input aane ke baad layer ka kaam - compute, report sections, aur output aage bhejna
+// (pass 1 output layer backward f(x1) bhejti hai, input buffer mein bana kar)
+void run_layer_stage(const LayerProcessSpec *spec, const PlanStage *stage, double *weights,
+                     double *input_data, double *output, AsyncIO *report_io, int report_fd) {
+    int num_neurons = spec->num_neurons;
+    ReportSection section;
+    uint64_t busy_start = monotonic_ns();
+    
+    // Threads create karke computation karo (har panel ek thread hai)
+    compute_layer_output(spec->stage_index, stage, input_data, weights, output);
+    write_layer_report(begin_report_section(&section), spec, input_data, output);
+    submit_report_section(report_io, report_fd, &section);
+    
+    // Next layer ko pipe se output bhejo (IPC) - pass 1 output layer backward data bhejti hai
+    // (replay mein beech ke stages ka write_fd -1 hota hai, backward section phir bhi likhna hai)
+    double *send_data = output;
+    if (stage->applies_backward) {
+        // Input ab kaam ka nahi - f(x1) usi buffer mein
+        printf("  Processing complete\n\n");
+        send_data = input_data;
+        backward_pass(begin_report_section(&section), output, num_neurons, send_data);
+        submit_report_section(report_io, report_fd, &section);
+    }
+    if (spec->write_fd >= 0 && !write_to_pipe(spec->write_fd, send_data, num_neurons)) {
+        fprintf(stderr, "ERROR: Failed to write %s\n",
+                send_data == output ? "to pipe" : "backward data");
+        exit(1);
+    }
+    if (send_data != output) {
+        printf("  Backward computation complete\n\n");
+    }
+    
+    if (spec->pass == 1 && spec->kind == INPUT_LAYER) {
+        printf("  Output sent to next layer (processing complete)\n\n");
+    } else if (spec->pass == 1 && spec->kind == HIDDEN_LAYER) {
+        printf("  Processing complete\n\n");
+    }
+    metrics_work_done(spec->stage_index, 1, monotonic_ns() - busy_start);
+}
+
+// Layer process - har layer alag process hai (fork se create hua)
+// Dono forward passes ki har layer yahi function chalati hai, spec batata hai kaunsi
+void layer_process(const LayerProcessSpec *spec) {
+    metrics_stage_start(spec->stage_index);
+    print_layer_banner(spec);
+    
+    // Is process ke liye output file kholo - sections report_cursor ke offsets par
+    // async likhe jaate hain, compute aur pipe send un writes ka wait nahi karte
+    int report_fd = open("output.txt", O_WRONLY);
+    if (report_fd < 0) {
+        fprintf(stderr, "ERROR: Cannot open output.txt\n");
+        exit(1);
+    }
+    AsyncIO report_io;
+    async_io_init(&report_io);
+    
+    // Weights ka prefetch shuru karo - jab tak upstream layers compute kar rahi hain,
+    // yeh thread plan ke byte range se is layer ke weights parse kar leta hai
+    const PlanStage *stage = &execution_plan.stages[spec->stage_index];
+    WeightPrefetch prefetch;
+    start_weight_prefetch(&prefetch, stage);
+    
+    // Activations plan ke shared ping-pong pair mein - input ek mein, output doosre mein
+    double *input_data = execution_plan.activations[stage->input_buffer];
+    receive_layer_input(spec, stage, input_data);
+    if (spec->read_fd >= 0) close(spec->read_fd);
+    
+    // Prefetch complete hone ka wait karo
+    double *weights = finish_weight_prefetch(&prefetch);
+    if (!weights) {
+        fprintf(stderr, "ERROR: Insufficient weight data%s\n",
+                spec->pass == 2 && spec->kind == INPUT_LAYER ? " for second pass" : "");
+        exit(1);
+    }
+    
+    run_layer_stage(spec, stage, weights, input_data,
+                    execution_plan.activations[stage->output_buffer], &report_io, report_fd);
+    if (spec->write_fd >= 0) close(spec->write_fd);
+    
+    // Cleanup - resources free karo (activation buffers plan ke hain)
+    free(weights);
+    if (!async_io_wait_all(&report_io)) {
+        fprintf(stderr, "ERROR: Failed to write output.txt\n");
+        exit(1);
+    }
+    async_io_destroy(&report_io);
+    close(report_fd);
+    metrics_stage_finish(spec->stage_index);
+    exit(0);  // Process complete
+}
+
+// Pass aur position (0 = input, 1..L = hidden, L+1 = output) se layer spec
+LayerProcessSpec make_layer_spec(int pass, int position, int layers_count, int neurons_count,
+                                 int read_fd, int write_fd) {
+    LayerProcessSpec spec;
+    spec.pass = pass;
+    spec.kind = (position == 0) ? INPUT_LAYER :
+                (position == layers_count + 1) ? OUTPUT_LAYER : HIDDEN_LAYER;
+    spec.layer_num = position;
+    spec.stage_index = (pass - 1) * (layers_count + 2) + position;
+    spec.num_neurons = neurons_count;
+    spec.read_fd = read_fd;
+    spec.write_fd = write_fd;
+    return spec;
+}
+
+// Ek forward pass ke layer processes fork karo (input, hidden 1..L, output)
+// first_position: isse pehle ki layers fork nahi hoti (--incremental replay) - 0 = sab
+// chain_in_fd: first_position wali layer ka input (pass 1 position 0 mein -1, pass 2 mein
+//              backward pipe, replay ke baad main ki resume pipe)
+// chain_out_fd: aakhri layer ka output (pass 1 mein backward pipe, pass 2 mein -1)
+// pids: jo layers fork nahi hui unka pid -1
+void fork_forward_pass(int pass, int layers_count, int neurons_count, int first_position,
+                       int chain_in_fd, int chain_out_fd, pid_t *pids) {
+    // Har layer ke beech mein ek pipe: input->hidden1, hidden1->hidden2, ..., hidden->output
+    int forward_pipes[layers_count + 1][2];
+    for (int i = 0; i <= layers_count; i++) {
+        if (pipe(forward_pipes[i]) == -1) {
+            perror("pipe");
+            exit(1);
+        }
+    }
+    
+    for (int i = 0; i < layers_count + 2; i++) {
+        if (i < first_position) {
+            pids[i] = -1;
+            continue;
+        }
+        LayerProcessSpec spec = make_layer_spec(
+            pass, i, layers_count, neurons_count,
+            (i == first_position) ? chain_in_fd : forward_pipes[i - 1][0],
+            (i == layers_count + 1) ? chain_out_fd : forward_pipes[i][1]);
+        
+        // fork() ek naya process create karta hai - yeh OS concept hai
+        fflush(stdout);  // Buffered console output child mein duplicate na ho
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            // Child process - sirf apne do pipe ends rakho, baaki band karo
+            for (int j = 0; j <= layers_count; j++) {
+                if (forward_pipes[j][0] != spec.read_fd) close(forward_pipes[j][0]);
+                if (forward_pipes[j][1] != spec.write_fd) close(forward_pipes[j][1]);
+            }
+            layer_process(&spec);
+        } else if (pids[i] < 0) {
+            perror("fork");  // Fork fail ho gaya
+            exit(1);
+        }
+    }
+    
+    // Parent process - is pass ke andar ke pipes children use karenge
+    for (int i = 0; i <= layers_count; i++) {
+        close(forward_pipes[i][0]);
+        close(forward_pipes[i][1]);
+    }
+}
+
+// Report ka header likho aur report_cursor ko header ke end par set karo
+// fp: truncate karke khuli output.txt - yahin band ho jati hai, layers alag se kholti hain
+void begin_report_file(FILE *fp, int layers_count, int neurons_count) {
+    fprintf(fp, "NEURAL NETWORK SIMULATION REPORT\n");
+    fprintf(fp, "=================================\n");
+    fprintf(fp, "Configuration: %d Hidden Layers | %d Neurons Per Layer\n\n", 
+            layers_count, neurons_count);
+    fflush(fp);  // Ensure header is written before fork
+    
+    // Report cursor shared memory mein - children header ke baad se apne sections reserve karenge
+    if (!report_cursor) {
+        report_cursor = static_cast<ReportCursor *>(mmap(NULL, sizeof(ReportCursor),
+                                                         PROT_READ | PROT_WRITE,
+                                                         MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+        if (report_cursor == MAP_FAILED) {
+            perror("mmap");
+            exit(1);
+        }
+    }
+    report_cursor->next_offset = ftell(fp);
+    fclose(fp);  // Close in main - children will open separately
+}
+
+void print_second_pass_header() {
+    printf("[PHASE] SECOND FORWARD PASS\n");
+    printf("  Using backward outputs as new inputs...\n\n");
+    fflush(stdout);
+}
+
+// --incremental: stages 0..first_stage-1 checkpoint mein reused mark hain - main unhe khud
+// replay karta hai (na fork, na weights): wahi console lines aur report sections jo layer
+// processes likhte. Aakhri replayed stage apna output resume_fd par bhejta hai.
+void replay_checkpointed_stages(int first_stage, int resume_fd) {
+    if (first_stage == 0) return;
+    int layers_count = execution_plan.hidden_layers;
+    int report_fd = open("output.txt", O_WRONLY);
+    if (report_fd < 0) {
+        fprintf(stderr, "ERROR: Cannot open output.txt\n");
+        exit(1);
+    }
+    AsyncIO report_io;
+    async_io_init(&report_io);
+    double input[MAX_NEURONS], output[MAX_NEURONS];
+    
+    for (int s = 0; s < first_stage; s++) {
+        int pass = (s < layers_count + 2) ? 1 : 2;
+        int position = s - (pass - 1) * (layers_count + 2);
+        if (s == layers_count + 2) print_second_pass_header();
+        LayerProcessSpec spec = make_layer_spec(pass, position, layers_count,
+                                                execution_plan.neurons_per_layer,
+                                                (s == 0) ? -1 : resume_fd,
+                                                (s == first_stage - 1) ? resume_fd : -1);
+        const PlanStage *stage = &execution_plan.stages[s];
+        metrics_stage_start(s);
+        print_layer_banner(&spec);
+        if (s == 0) receive_layer_input(&spec, stage, input);  // Plan ki input values
+        run_layer_stage(&spec, stage, NULL, input, output, &report_io, report_fd);
+        metrics_stage_finish(s);
+        
+        // Agle stage ka input - backward stage ne f(x1) input buffer mein hi banaya hai
+        if (!stage->applies_backward) {
+            memcpy(input, output, stage->num_neurons * sizeof(double));
+        }
+    }
+    
+    if (!async_io_wait_all(&report_io)) {
+        fprintf(stderr, "ERROR: Failed to write output.txt\n");
+        exit(1);
+    }
+    async_io_destroy(&report_io);
+    close(report_fd);
+}
+
+// Dono forward passes ke layer processes fork karo aur sab ke khatam hone ka wait
+// first_stage: isse pehle ke stages checkpoint se replay hote hain (0 = sab fork)
+// Return: kitne layer processes safal exit nahi hue (0 = sab theek)
+int run_forked_passes(int layers_count, int neurons_count, int first_stage) {
+    int pass_stages = layers_count + 2;
+    
+    // Replay pehle - aakhri replayed stage ka output resume pipe mein rehta hai (ek vector
+    // pipe buffer mein aa jata hai) aur fork hone wala pehla stage wahin se padhta hai
+    int resume_pipe[2] = { -1, -1 };
+    if (first_stage > 0 && first_stage < 2 * pass_stages && pipe(resume_pipe) == -1) {
+        perror("pipe");
+        exit(1);
+    }
+    replay_checkpointed_stages(first_stage, resume_pipe[1]);
+    if (resume_pipe[1] >= 0) close(resume_pipe[1]);
+    
+    // ========== FORWARD PASS 1 ==========
+    // Pehla forward pass - input se output tak
+    pid_t first_pass_pids[pass_stages];
+    int second_pass_in = resume_pipe[0];
+    if (first_stage < pass_stages) {
+        // Backward pass ke liye pipe create karo (output se input tak)
+        int backward_pipe[2];
+        if (pipe(backward_pipe) == -1) {
+            perror("pipe");
+            exit(1);
+        }
+        
+        // Input, hidden aur output layer processes create karo (fork se)
+        fork_forward_pass(1, layers_count, neurons_count, first_stage, resume_pipe[0],
+                          backward_pipe[1], first_pass_pids);
+        close(backward_pipe[1]);  // Output layer ke paas hai
+        if (resume_pipe[0] >= 0) close(resume_pipe[0]);
+        second_pass_in = backward_pipe[0];
+    } else {
+        for (int i = 0; i < pass_stages; i++) first_pass_pids[i] = -1;
+    }
+    
+    // ========== SECOND FORWARD PASS ==========
+    // Doosra forward pass - backward outputs ko naye inputs ki tarah use karke
+    // Pehle pass ka wait nahi karte: second pass ke processes abhi fork ho jate hain,
+    // apne weights prefetch karte hain aur backward_pipe par data aane tak block rehte hain
+    pid_t second_pass_pids[pass_stages];
+    if (first_stage < 2 * pass_stages) {
+        if (first_stage <= pass_stages) print_second_pass_header();
+        int first_position = first_stage > pass_stages ? first_stage - pass_stages : 0;
+        fork_forward_pass(2, layers_count, neurons_count, first_position, second_pass_in, -1,
+                          second_pass_pids);
+        close(second_pass_in);  // Second pass ki pehli forked layer ke paas hai
+    } else {
+        for (int i = 0; i < pass_stages; i++) second_pass_pids[i] = -1;
+    }
+    
+    // Dono passes ke saare processes ke complete hone ka wait karo (waitpid)
+    // Yeh zaroori hai taake parent process sab child processes ke khatam hone ka wait kare
+    int failed = 0, status;
+    for (int i = 0; i < pass_stages; i++) {
+        if (first_pass_pids[i] < 0) continue;
+        waitpid(first_pass_pids[i], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+    }
+    for (int i = 0; i < pass_stages; i++) {
+        if (second_pass_pids[i] < 0) continue;
+        waitpid(second_pass_pids[i], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+    }
+    return failed;
+}
+
+// Command line options - bina options ke purana one-shot simulation chalta hai
+struct RunOptions {
+    const char *daemon_socket;  // --daemon PATH: resident inference daemon
+    int max_batch;              // --max-batch N
+    int batch_window_us;        // --batch-window-us N
+    int cache_entries;          // --cache N: shared LRU cache size (0 = off)
+    int cache_layers;           // --cache-layers: per-layer activations bhi (alag cache mein)
+    int incremental;            // --incremental: checkpoint se unchanged layers reuse karo
+    int max_iterations;         // --iterations N: feedback loop mode (0 = normal two-pass)
+    double tolerance;           // --tolerance T: convergence par loop roko
+    int layers_count;           // --layers N: prompt ki jagah (0 = stdin se poocho)
+    int neurons_count;          // --neurons N
+    int node_port;              // --node PORT: distributed stage range serve karo
+    const char *node_stages;    // --stages FIRST-LAST
+    const char *node_next;      // --next HOST:PORT (agla node ya launcher)
+    const char *launch_plan;    // --launch FILE: placement file se nodes chalao
+    const char *advertise_host; // --advertise HOST: launcher ka address nodes ke liye
+    const char *output_bin;     // --output-bin FILE: daemon batch results binary mein likho
+    int show_plan;              // --show-plan: execution plan print karke exit
+    int latency_samples;        // --latency-bench N: pipe vs slot ring benchmark (0 = off)
+    int pool_runs;              // --pool-runs R / --pool-bench R: pre-forked pool (0 = off)
+    int pool_bench;             // --pool-bench: fork-per-layer se comparison bhi
+    const char *metrics_path;   // --metrics FILE: stages ke live counters is page mein
+    const char *top_path;       // --top FILE: doosri run ka metrics page dekho
+    int top_interval_ms;        // --interval-ms N: --top ka refresh interval
+};
+
+// ========== ACTIVATION CACHE (SHARED MEMORY LRU) ==========
+// Same input baar baar aaye to poori pipeline dobara chalane ki zaroorat nahi.
+// Cache fork se pehle MAP_SHARED memory mein banta hai taake daemon aur saare
+// layer processes ek hi cache dekhein. Key = (stage, input vector, weights version).
+
+const int CACHE_FINAL_STAGE = -1;   // Poore network ka final output (stage nahi)
+
+struct CacheEntry {
+    int stage;                      // CACHE_FINAL_STAGE ya layer stage index
+    int input_count;
+    int output_count;
+    int lru_prev, lru_next;         // LRU list (head = sabse naya)
+    int bucket_next;                // Hash bucket chain
+    uint64_t key_hash;
+    uint64_t version;               // Weights version - weights badlein to purani entries miss hongi
+    double inputs[MAX_NEURONS];     // Hash collision check ke liye poora input
+    double outputs[MAX_NEURONS];
+};
+
+struct ActivationCache {
+    pthread_mutex_t lock;           // PTHREAD_PROCESS_SHARED - sab processes ke beech
+    int capacity;
+    int bucket_count;
+    int used;
+    int lru_head, lru_tail;
+    long final_hits, final_misses;  // Daemon level (poora network)
+    long layer_hits, layer_misses;  // Per-layer activations
+    long evictions;
+    int *buckets;                   // Isi mapping ke andar point karte hain
+    CacheEntry *entries;
+};
+
+// Fork se pehle cache banao - anonymous shared mapping sab children ko milti hai
+ActivationCache *create_activation_cache(int capacity) {
+    int bucket_count = capacity * 2;
+    size_t size = sizeof(ActivationCache) + bucket_count * sizeof(int) +
+                  capacity * sizeof(CacheEntry);
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap");
+        return NULL;
+    }
+    
+    ActivationCache *cache = static_cast<ActivationCache *>(mem);
+    memset(cache, 0, sizeof(*cache));
+    cache->capacity = capacity;
+    cache->bucket_count = bucket_count;
+    cache->lru_head = cache->lru_tail = -1;
+    cache->buckets = reinterpret_cast<int *>(cache + 1);
+    cache->entries = reinterpret_cast<CacheEntry *>(cache->buckets + bucket_count);
+    for (int i = 0; i < bucket_count; i++) cache->buckets[i] = -1;
+    
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&cache->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    return cache;
+}
+
+void destroy_activation_cache(ActivationCache *cache) {
+    if (!cache) return;
+    size_t size = sizeof(ActivationCache) + cache->bucket_count * sizeof(int) +
+                  cache->capacity * sizeof(CacheEntry);
+    pthread_mutex_destroy(&cache->lock);
+    munmap(cache, size);
+}
+
+// LRU list se entry nikalo (lock pakda hua hona chahiye)
+void cache_lru_unlink(ActivationCache *cache, int idx) {
+    CacheEntry *e = &cache->entries[idx];
+    if (e->lru_prev >= 0) cache->entries[e->lru_prev].lru_next = e->lru_next;
+    else cache->lru_head = e->lru_next;
+    if (e->lru_next >= 0) cache->entries[e->lru_next].lru_prev = e->lru_prev;
+    else cache->lru_tail = e->lru_prev;
+}
+
+// Entry ko LRU list ke head (most recent) par daalo
+void cache_lru_push_front(ActivationCache *cache, int idx) {
+    CacheEntry *e = &cache->entries[idx];
+    e->lru_prev = -1;
+    e->lru_next = cache->lru_head;
+    if (cache->lru_head >= 0) cache->entries[cache->lru_head].lru_prev = idx;
+    cache->lru_head = idx;
+    if (cache->lru_tail < 0) cache->lru_tail = idx;
+}
+
+uint64_t cache_key_hash(int stage, const double *inputs, int input_count, uint64_t version) {
+    return hash_doubles(inputs, input_count, version + (uint64_t)(stage + 1) * 0x9E3779B97F4A7C15ULL);
+}
+
+// Bucket chain mein matching entry dhoondo, nahi mili to -1
+int cache_find(ActivationCache *cache, int stage, const double *inputs, int input_count,
+               uint64_t version, uint64_t key_hash) {
+    int idx = cache->buckets[key_hash % cache->bucket_count];
+    while (idx >= 0) {
+        CacheEntry *e = &cache->entries[idx];
+        if (e->key_hash == key_hash && e->stage == stage && e->version == version &&
+            e->input_count == input_count &&
+            memcmp(e->inputs, inputs, input_count * sizeof(double)) == 0) {
+            return idx;
+        }
+        idx = e->bucket_next;
+    }
+    return -1;
+}
+
+// Cache se output lao - hit par 1 return aur output copy
+int cache_lookup(ActivationCache *cache, int stage, const double *inputs, int input_count,
+                 uint64_t version, double *output) {
+    uint64_t key_hash = cache_key_hash(stage, inputs, input_count, version);
+    pthread_mutex_lock(&cache->lock);
+    int idx = cache_find(cache, stage, inputs, input_count, version, key_hash);
+    if (idx >= 0) {
+        CacheEntry *e = &cache->entries[idx];
+        memcpy(output, e->outputs, e->output_count * sizeof(double));
+        cache_lru_unlink(cache, idx);
+        cache_lru_push_front(cache, idx);
+    }
+    if (stage == CACHE_FINAL_STAGE) {
+        if (idx >= 0) cache->final_hits++; else cache->final_misses++;
+    } else {
+        if (idx >= 0) cache->layer_hits++; else cache->layer_misses++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return idx >= 0;
+}
+
+// Naya result cache mein daalo - bhara ho to least recently used entry nikal do
+void cache_insert(ActivationCache *cache, int stage, const double *inputs, int input_count,
+                  uint64_t version, const double *output, int output_count) {
+    uint64_t key_hash = cache_key_hash(stage, inputs, input_count, version);
+    pthread_mutex_lock(&cache->lock);
+    int idx = cache_find(cache, stage, inputs, input_count, version, key_hash);
+    if (idx >= 0) {
+        cache_lru_unlink(cache, idx);  // Pehle se hai - sirf refresh
+    } else {
+        if (cache->used < cache->capacity) {
+            idx = cache->used++;
+        } else {
+            // Tail (sabse purani) entry evict karo aur uski bucket chain se hatao
+            idx = cache->lru_tail;
+            cache_lru_unlink(cache, idx);
+            int *link = &cache->buckets[cache->entries[idx].key_hash % cache->bucket_count];
+            while (*link != idx) link = &cache->entries[*link].bucket_next;
+            *link = cache->entries[idx].bucket_next;
+            cache->evictions++;
+        }
+        CacheEntry *e = &cache->entries[idx];
+        e->stage = stage;
+        e->input_count = input_count;
+        e->key_hash = key_hash;
+        e->version = version;
+        memcpy(e->inputs, inputs, input_count * sizeof(double));
+        int *bucket = &cache->buckets[key_hash % cache->bucket_count];
+        e->bucket_next = *bucket;
+        *bucket = idx;
+    }
+    CacheEntry *e = &cache->entries[idx];
+    e->output_count = output_count;
+    memcpy(e->outputs, output, output_count * sizeof(double));
+    cache_lru_push_front(cache, idx);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+// Final-output cache aur (--cache-layers) alag per-layer cache ke counters
+void format_cache_stats(ActivationCache *cache, ActivationCache *layer_cache, char *buf,
+                        size_t buf_size) {
+    if (!cache) {
+        snprintf(buf, buf_size, "cache=off");
+        return;
+    }
+    pthread_mutex_lock(&cache->lock);
+    int len = snprintf(buf, buf_size, "cache_hits=%ld cache_misses=%ld cache_entries=%d/%d "
+                       "evictions=%ld", cache->final_hits, cache->final_misses,
+                       cache->used, cache->capacity, cache->evictions);
+    pthread_mutex_unlock(&cache->lock);
+    if (!layer_cache || len < 0 || (size_t)len >= buf_size) return;
+    
+    pthread_mutex_lock(&layer_cache->lock);
+    snprintf(buf + len, buf_size - len, " layer_hits=%ld layer_misses=%ld layer_entries=%d/%d "
+             "layer_evictions=%ld", layer_cache->layer_hits, layer_cache->layer_misses,
+             layer_cache->used, layer_cache->capacity, layer_cache->evictions);
+    pthread_mutex_unlock(&layer_cache->lock);
+}
+
+// ========== DAEMON MODE (RESIDENT PIPELINE) ==========
+// Daemon mode mein network sirf ek baar load hota hai, layer processes ek baar
+// fork hote hain aur Unix domain socket se aane wali requests ko micro-batches
+// mein process karte rehte hain.
+
+// Ek pipeline stage ka data - stage order input.txt ke layout jaisa hai:
+// input, hidden 1..L, output, second input, second hidden 1..L, second output
+struct LayerStage {
+    int input_size;         // Har input vector ki width
+    int num_neurons;        // Is stage ke neurons (output width)
+    int applies_backward;   // Output layer ke baad f(x1) lagana hai ya nahi
+    StageKernel kernel;     // Execution plan ka chuna hua kernel
+    double *weights;        // Kernel ke layout mein (neuron threads: packed panels)
+    uint64_t weights_version;  // Is stage ke weights ka hash (cache key ke liye)
+};
+
+// Poora network - input.txt ek hi baar parse hoti hai
+struct NetworkModel {
+    int hidden_layers;
+    int neurons_per_layer;
+    int stage_count;                    // 2 * (hidden_layers + 2)
+    double input_values[INPUT_NEURONS]; // input.txt ki pehli line
+    uint64_t weights_version;           // Saare stages ke versions ka combined hash
+    LayerStage *stages;
+};
+
+// Execution plan banao, phir saare stages ke weights ek saath parse karo
+// (stages input.txt mein lagataar hain - ek hi read-ahead stream kaafi hai)
+int load_network_model(const char *path, int hidden_layers, int neurons,
+                       NetworkModel *model) {
+    ExecutionPlan *plan = &execution_plan;
+    if (!build_execution_plan(path, hidden_layers, neurons, plan)) {
+        return 0;
+    }
+    open_weight_cache(path, plan);
+    FILE *input_fp = NULL;
+    if (!weight_cache_ready) {
+        input_fp = open_async_reader(path, plan->stages[0].weight_begin,
+                                     plan->stages[plan->stage_count - 1].weight_end);
+        if (!input_fp) {
+            fprintf(stderr, "ERROR: Cannot open %s\n", path);
+            finish_weight_cache(0);
+            return 0;
+        }
+    }
+    
+    model->hidden_layers = hidden_layers;
+    model->neurons_per_layer = neurons;
+    model->stage_count = plan->stage_count;
+    model->stages = static_cast<LayerStage *>(calloc(model->stage_count, sizeof(LayerStage)));
+    if (!model->stages) {
+        fprintf(stderr, "ERROR: Memory allocation failed\n");
+        if (input_fp) fclose(input_fp);
+        return 0;
+    }
+    memcpy(model->input_values, plan->input_values, sizeof(model->input_values));
+    
+    for (int s = 0; s < model->stage_count; s++) {
+        LayerStage *stage = &model->stages[s];
+        stage->input_size = plan->stages[s].input_size;
+        stage->num_neurons = plan->stages[s].num_neurons;
+        stage->applies_backward = plan->stages[s].applies_backward;
+        stage->kernel = plan->stages[s].kernel;
+        
+        stage->weights = load_stage_weights(input_fp, &plan->stages[s]);
+        if (!stage->weights) {
+            fprintf(stderr, "ERROR: Insufficient weight data for stage %d\n", s);
+            if (input_fp) fclose(input_fp);
+            finish_weight_cache(0);
+            return 0;
+        }
+        stage->weights_version = hash_doubles(stage->weights, plan->stages[s].weight_count,
+                                              s ^ reduction_signature());
+    }
+    
+    // Network version - kisi bhi stage ke weights badlein to yeh badal jata hai
+    uint64_t versions[model->stage_count];
+    for (int s = 0; s < model->stage_count; s++) versions[s] = model->stages[s].weights_version;
+    model->weights_version = hash_doubles(reinterpret_cast<double *>(versions),
+                                          model->stage_count, neurons);
+    
+    if (input_fp) fclose(input_fp);
+    finish_weight_cache(1);
+    return 1;
+}
+
+void free_network_model(NetworkModel *model) {
+    if (!model->stages) return;
+    for (int s = 0; s < model->stage_count; s++) {
+        free(model->stages[s].weights);
+    }
+    free(model->stages);
+    model->stages = NULL;
+}
+
+// Resident stage worker - process zinda rehta hai aur pipe se batches padhta
+// rehta hai jab tak upstream pipe band (EOF) na ho jaye. Input/output buffers
+// ek hi baar allocate hote hain aur har batch/iteration mein reuse hote hain.
+// layer_cache diya ho to jin rows ka activation cache mein hai woh compute nahi hoti
+void resident_stage_process(const LayerStage *stage, int stage_index, ActivationCache *layer_cache,
+                            Channel upstream, Channel downstream) {
+    int width = stage->num_neurons;
+    int in_width = stage->input_size;
+    double *input_data = NULL, *output = NULL, *miss_inputs = NULL, *computed = NULL;
+    int input_capacity = 0, row_capacity = 0;
+    int input_count;
+    metrics_stage_start(stage_index);
+    
+    uint64_t wait_start = monotonic_ns();
+    while (channel_recv(&upstream, &input_data, &input_capacity, &input_count)) {
+        int rows = input_count / in_width;
+        uint64_t busy_start = monotonic_ns();
+        metrics_input_received(stage_index, busy_start - wait_start,
+                               channel_queued_bytes(&upstream));
+        
+        // Batch pichle se bada hai to hi buffers bade karo
+        if (rows > row_capacity) {
+            row_capacity = rows;
+            output = static_cast<double *>(realloc(output, rows * width * sizeof(double)));
+            computed = static_cast<double *>(realloc(computed, rows * width * sizeof(double)));
+            miss_inputs = static_cast<double *>(realloc(miss_inputs, rows * in_width * sizeof(double)));
+            if (!output || !computed || !miss_inputs) {
+                fprintf(stderr, "ERROR: Memory allocation failed\n");
+                exit(1);
+            }
+        }
+        
+        if (!layer_cache) {
+            launch_stage_kernel(stage->kernel, width, in_width, rows, input_data,
+                                stage->weights, output);
+        } else {
+            // Cache miss wali rows ko compact karke sirf unhi ko compute karo
+            int miss_rows[rows];
+            int misses = 0;
+            for (int r = 0; r < rows; r++) {
+                double *row = &input_data[r * in_width];
+                if (!cache_lookup(layer_cache, stage_index, row, in_width,
+                                  stage->weights_version, &output[r * width])) {
+                    memcpy(&miss_inputs[misses * in_width], row, in_width * sizeof(double));
+                    miss_rows[misses++] = r;
+                }
+            }
+            if (misses > 0) {
+                launch_stage_kernel(stage->kernel, width, in_width, misses, miss_inputs,
+                                    stage->weights, computed);
+                for (int m = 0; m < misses; m++) {
+                    memcpy(&output[miss_rows[m] * width], &computed[m * width], width * sizeof(double));
+                    cache_insert(layer_cache, stage_index, &miss_inputs[m * in_width], in_width,
+                                 stage->weights_version, &computed[m * width], width);
+                }
+            }
+        }
+        
+        if (stage->applies_backward) {
+            apply_backward_formula(output, rows * width);
+        }
+        
+        if (!channel_send(&downstream, output, rows * width)) {
+            fprintf(stderr, "ERROR: Stage failed to send downstream (PID: %d)\n", getpid());
+            exit(1);
+        }
+        wait_start = monotonic_ns();
+        metrics_work_done(stage_index, rows, wait_start - busy_start);
+    }
+    
+    // Upstream band ho gaya - downstream ko bhi EOF milega
+    free(input_data);
+    free(output);
+    free(computed);
+    free(miss_inputs);
+    channel_drop(&upstream);
+    channel_finish(&downstream);
+    metrics_stage_finish(stage_index);
+    exit(0);
+}
+
+// Latency benchmark ka stage - bina compute ke message aage bhejo (sirf handoff ka cost)
+void relay_stage_process(Channel upstream, Channel downstream) {
+    double *buffer = NULL;
+    int capacity = 0, count;
+    while (channel_recv(&upstream, &buffer, &capacity, &count)) {
+        if (!channel_send(&downstream, buffer, count)) {
+            fprintf(stderr, "ERROR: Relay failed to send downstream (PID: %d)\n", getpid());
+            exit(1);
+        }
+    }
+    free(buffer);
+    channel_drop(&upstream);
+    channel_finish(&downstream);
+    exit(0);
+}
+
+// Stages first..last ke resident workers fork karo aur beech mein links lagao
+// (pipes, ya --low-latency mein slot rings + har stage apne core par pinned)
+// Pehla stage upstream se padhta hai, aakhri downstream mein likhta hai (pipe, TCP ya ring)
+// link_capacity: ek message mein max doubles (ring slots ka size)
+// child_close_fds: parent ke woh fds jo children ko band karne hain (warna EOF nahi aata)
+// model NULL ho to stages sirf relay karte hain (latency benchmark)
+void fork_stage_range(const NetworkModel *model, int first, int last, ActivationCache *layer_cache,
+                      int link_capacity, Channel upstream, Channel downstream,
+                      const int *child_close_fds, int child_close_count, pid_t *pids) {
+    // Link k: stage (first + k) -> stage (first + k + 1)
+    int count = last - first + 1;
+    Channel readers[count], writers[count];
+    for (int i = 0; i < count - 1; i++) {
+        make_link(link_capacity, &readers[i], &writers[i]);
+    }
+    
+    for (int k = 0; k < count; k++) {
+        fflush(stdout);
+        pids[k] = fork();
+        if (pids[k] == 0) {
+            // Child - sirf apne do ends rakho, baaki sab band (EOF chain ke liye zaroori)
+            for (int i = 0; i < count - 1; i++) {
+                if (i != k - 1) channel_drop(&readers[i]);
+                if (i != k) channel_drop(&writers[i]);
+            }
+            if (k != 0) channel_drop(&upstream);
+            if (k != count - 1) channel_drop(&downstream);
+            for (int i = 0; i < child_close_count; i++) {
+                close(child_close_fds[i]);
+            }
+            if (low_latency) pin_to_cpu(first + k + 1);  // CPU 0 parent ke liye
+            Channel in = (k == 0) ? upstream : readers[k - 1];
+            Channel out = (k == count - 1) ? downstream : writers[k];
+            if (!model) relay_stage_process(in, out);
+            resident_stage_process(&model->stages[first + k], first + k, layer_cache, in, out);
+        } else if (pids[k] < 0) {
+            perror("fork");
+            exit(1);
+        }
+    }
+    
+    // Parent - andar ke links sirf children ke liye hain
+    for (int i = 0; i < count - 1; i++) {
+        channel_drop(&readers[i]);
+        channel_drop(&writers[i]);
+    }
+}
+
+// Poori resident chain (stages first..last) fork karo - parent ko chain ka
+// input (likhne ke liye) aur output (padhne ke liye) channel milta hai
+void fork_resident_chain(const NetworkModel *model, int first, int last,
+                         ActivationCache *layer_cache, int link_capacity,
+                         Channel *chain_in, Channel *chain_out, pid_t *pids) {
+    Channel in_reader, in_writer, out_reader, out_writer;
+    make_link(link_capacity, &in_reader, &in_writer);
+    make_link(link_capacity, &out_reader, &out_writer);
+    
+    int parent_ends[2];
+    int parent_end_count = 0;
+    if (in_writer.fd >= 0) parent_ends[parent_end_count++] = in_writer.fd;
+    if (out_reader.fd >= 0) parent_ends[parent_end_count++] = out_reader.fd;
+    fork_stage_range(model, first, last, layer_cache, link_capacity, in_reader, out_writer,
+                     parent_ends, parent_end_count, pids);
+    
+    // Parent - sirf chain ka input write end aur output read end rakho
+    channel_drop(&in_reader);
+    channel_drop(&out_writer);
+    *chain_in = in_writer;
+    *chain_out = out_reader;
+}
+
+// Resident chain band karo - input ka EOF poori chain mein jata hai, phir workers reap karo
+void stop_resident_chain(const Channel *chain_in, const Channel *chain_out, const pid_t *pids,
+                         int count) {
+    channel_finish(chain_in);
+    channel_drop(chain_out);
+    for (int i = 0; i < count; i++) {
+        waitpid(pids[i], NULL, 0);
+    }
+}
+
+// Ek client request - client thread isko queue mein daal kar wait karta hai
+struct InferenceRequest {
+    double inputs[INPUT_NEURONS];
+    double outputs[MAX_NEURONS];
+    int done;                       // Batch complete hone par 1
+    struct timespec enqueued_at;    // Latency measure karne ke liye
+    pthread_cond_t done_cond;
+    InferenceRequest *next;
+};
+
+// Pipeline mein bheja gaya batch - collector isi order mein results padhta hai
+struct InflightBatch {
+    int size;
+    InferenceRequest *requests[MAX_BATCH];
+    InflightBatch *next;
+};
+
+// Daemon ki shared state - sab threads isko file_lock jaisi ek mutex se access karte hain
+struct DaemonState {
+    const NetworkModel *model;
+    ActivationCache *cache;         // NULL agar --cache nahi diya
+    ActivationCache *layer_cache;   // --cache-layers ka alag cache (NULL = off)
+    int max_batch;
+    int batch_window_us;
+    Channel pipeline_in;            // Pehle stage ko batch bhejne ke liye
+    Channel pipeline_out;           // Aakhri stage se results ke liye
+    int output_bin_fd;              // --output-bin file (-1 = off), sirf collector likhta hai
+    int listen_fd;
+    volatile sig_atomic_t shutting_down;
+    
+    pthread_mutex_t lock;
+    pthread_cond_t queue_cond;      // Nayi request aayi
+    pthread_cond_t inflight_cond;   // Naya batch pipeline mein gaya
+    InferenceRequest *queue_head;
+    InferenceRequest *queue_tail;
+    int queue_len;
+    InflightBatch *inflight_head;
+    InflightBatch *inflight_tail;
+    int inflight_count;
+    int max_inflight;               // Har stage par ek batch - is se zyada ho to queue mein batch bade hote hain
+    int submitter_done;
+    
+    // Stats endpoint ke liye counters
+    struct timespec started_at;
+    long total_requests;
+    long total_batches;
+    double latency_us[LATENCY_SAMPLES];  // Ring buffer
+    long latency_count;
+};
+
+DaemonState daemon_state;
+
+// Do timestamps ka farq microseconds mein
+double elapsed_us(const struct timespec *from, const struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) * 1e6 + (to->tv_nsec - from->tv_nsec) / 1e3;
+}
+
+int compare_doubles(const void *a, const void *b) {
+    double x = *static_cast<const double *>(a);
+    double y = *static_cast<const double *>(b);
+    return (x > y) - (x < y);
+}
+
+// Batcher (submitter) thread - queue se micro-batch banata hai
+// Batch tab jata hai jab max_batch bhar jaye ya pehli request ka latency budget khatam ho
+void *daemon_submitter_thread(void *arg) {
+    DaemonState *ds = static_cast<DaemonState *>(arg);
+    int width = INPUT_NEURONS;
+    double *batch_inputs = static_cast<double *>(malloc(ds->max_batch * width * sizeof(double)));
+    
+    pthread_mutex_lock(&ds->lock);
+    while (1) {
+        while (ds->queue_len == 0 && !ds->shutting_down) {
+            pthread_cond_wait(&ds->queue_cond, &ds->lock);
+        }
+        if (ds->queue_len == 0 && ds->shutting_down) break;
+        
+        // Pipeline bhari hui hai to yahin ruko - is dauran aur requests queue mein jama hongi
+        while (ds->inflight_count >= ds->max_inflight) {
+            pthread_cond_wait(&ds->queue_cond, &ds->lock);
+        }
+        
+        // Pehli request ke time se latency budget count karo
+        struct timespec deadline = ds->queue_head->enqueued_at;
+        deadline.tv_nsec += (long)ds->batch_window_us * 1000;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        while (ds->queue_len < ds->max_batch && !ds->shutting_down) {
+            if (pthread_cond_timedwait(&ds->queue_cond, &ds->lock, &deadline) == ETIMEDOUT) break;
+        }
+        
+        // Queue se batch nikalo
+        InflightBatch *batch = static_cast<InflightBatch *>(malloc(sizeof(InflightBatch)));
+        batch->size = 0;
+        batch->next = NULL;
+        while (ds->queue_head && batch->size < ds->max_batch) {
+            InferenceRequest *req = ds->queue_head;
+            ds->queue_head = req->next;
+            ds->queue_len--;
+            memcpy(&batch_inputs[batch->size * width], req->inputs, width * sizeof(double));
+            batch->requests[batch->size++] = req;
+        }
+        if (!ds->queue_head) ds->queue_tail = NULL;
+        
+        // Collector ko batch ka pata hona chahiye is se pehle ke results aayein
+        if (ds->inflight_tail) ds->inflight_tail->next = batch;
+        else ds->inflight_head = batch;
+        ds->inflight_tail = batch;
+        ds->inflight_count++;
+        ds->total_batches++;
+        pthread_cond_signal(&ds->inflight_cond);
+        pthread_mutex_unlock(&ds->lock);
+        
+        // Pipe write lock ke bahar - pipeline busy ho to sirf yeh thread rukta hai
+        if (!channel_send(&ds->pipeline_in, batch_inputs, batch->size * width)) {
+            fprintf(stderr, "ERROR: Failed to submit batch to pipeline\n");
+            exit(1);
+        }
+        pthread_mutex_lock(&ds->lock);
+    }
+    ds->submitter_done = 1;
+    pthread_cond_signal(&ds->inflight_cond);
+    pthread_mutex_unlock(&ds->lock);
+    
+    // Pipeline ka input band karo - stages EOF dekh kar exit karenge
+    channel_finish(&ds->pipeline_in);
+    free(batch_inputs);
+    return NULL;
+}
+
+// Collector thread - pipeline ke aakhri stage se results padh kar clients ko jagata hai
+void *daemon_collector_thread(void *arg) {
+    DaemonState *ds = static_cast<DaemonState *>(arg);
+    int width = ds->model->neurons_per_layer;
+    int record_width = INPUT_NEURONS + width;  // Binary record: inputs phir outputs
+    off_t output_bin_offset = 0;
+    double *results = NULL;          // channel_recv ka reusable buffer
+    int results_capacity = 0, result_count;
+    AsyncIO output_io;
+    if (ds->output_bin_fd >= 0) async_io_init(&output_io);
+    
+    while (1) {
+        pthread_mutex_lock(&ds->lock);
+        while (!ds->inflight_head && !ds->submitter_done) {
+            pthread_cond_wait(&ds->inflight_cond, &ds->lock);
+        }
+        InflightBatch *batch = ds->inflight_head;
+        pthread_mutex_unlock(&ds->lock);
+        if (!batch) break;  // Submitter band aur kuch pending nahi
+        
+        if (!channel_recv(&ds->pipeline_out, &results, &results_capacity, &result_count) ||
+            result_count != batch->size * width) {
+            fprintf(stderr, "ERROR: Pipeline returned invalid batch\n");
+            exit(1);
+        }
+        
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        
+        pthread_mutex_lock(&ds->lock);
+        ds->inflight_head = batch->next;
+        if (!ds->inflight_head) ds->inflight_tail = NULL;
+        ds->inflight_count--;
+        pthread_cond_signal(&ds->queue_cond);  // Submitter pipeline slot ka wait kar raha ho sakta hai
+        for (int i = 0; i < batch->size; i++) {
+            InferenceRequest *req = batch->requests[i];
+            memcpy(req->outputs, &results[i * width], width * sizeof(double));
+            if (ds->cache) {
+                cache_insert(ds->cache, CACHE_FINAL_STAGE, req->inputs, INPUT_NEURONS,
+                             ds->model->weights_version, req->outputs, width);
+            }
+            ds->latency_us[ds->latency_count % LATENCY_SAMPLES] = elapsed_us(&req->enqueued_at, &now);
+            ds->latency_count++;
+            ds->total_requests++;
+            req->done = 1;
+            pthread_cond_signal(&req->done_cond);
+        }
+        pthread_mutex_unlock(&ds->lock);
+        
+        // Batch ke records async likho - agla batch padhne ke liye write ka wait nahi
+        if (ds->output_bin_fd >= 0) {
+            size_t record_bytes = batch->size * record_width * sizeof(double);
+            double *records = static_cast<double *>(malloc(record_bytes));
+            for (int i = 0; i < batch->size; i++) {
+                memcpy(&records[i * record_width], batch->requests[i]->inputs,
+                       INPUT_NEURONS * sizeof(double));
+                memcpy(&records[i * record_width + INPUT_NEURONS], &results[i * width],
+                       width * sizeof(double));
+            }
+            async_io_submit(&output_io, 1, ds->output_bin_fd, reinterpret_cast<char *>(records),
+                            record_bytes, output_bin_offset, 1);
+            output_bin_offset += record_bytes;
+        }
+        
+        free(batch);
+    }
+    free(results);
+    
+    if (ds->output_bin_fd >= 0) {
+        if (!async_io_wait_all(&output_io)) {
+            fprintf(stderr, "ERROR: Failed to write batch outputs\n");
+        }
+        async_io_destroy(&output_io);
+    }
+    channel_drop(&ds->pipeline_out);
+    return NULL;
+}
+
+// Stats line format karo: throughput aur latency percentiles
+// Har call ki apni sorted copy - kai clients ek saath STATS bhej sakte hain
+void format_daemon_stats(DaemonState *ds, char *buf, size_t buf_size) {
+    double *sorted = static_cast<double *>(malloc(LATENCY_SAMPLES * sizeof(double)));
+    if (!sorted) {
+        snprintf(buf, buf_size, "ERR out of memory\n");
+        return;
+    }
+    
+    pthread_mutex_lock(&ds->lock);
+    long samples = ds->latency_count < LATENCY_SAMPLES ? ds->latency_count : LATENCY_SAMPLES;
+    memcpy(sorted, ds->latency_us, samples * sizeof(double));
+    long requests = ds->total_requests;
+    long batches = ds->total_batches;
+    int queued = ds->queue_len;
+    pthread_mutex_unlock(&ds->lock);
+    
+    qsort(sorted, samples, sizeof(double), compare_doubles);
+    char cache_stats[256];
+    format_cache_stats(ds->cache, ds->layer_cache, cache_stats, sizeof(cache_stats));
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double uptime_s = elapsed_us(&ds->started_at, &now) / 1e6;
+    
+    double p50 = 0, p90 = 0, p99 = 0, max = 0;
+    if (samples > 0) {
+        p50 = sorted[(samples - 1) * 50 / 100];
+        p90 = sorted[(samples - 1) * 90 / 100];
+        p99 = sorted[(samples - 1) * 99 / 100];
+        max = sorted[samples - 1];
+    }
+    free(sorted);
+    snprintf(buf, buf_size,
+             "STATS requests=%ld batches=%ld avg_batch=%.2f queued=%d uptime_s=%.3f "
+             "throughput_rps=%.1f p50_us=%.1f p90_us=%.1f p99_us=%.1f max_us=%.1f %s\n",
+             requests, batches, batches ? (double)requests / batches : 0.0, queued,
+             uptime_s, uptime_s > 0 ? requests / uptime_s : 0.0, p50, p90, p99, max,
+             cache_stats);
+}
+
+// Ek client connection - line based protocol:
+//   INFER x1 x2   -> OK y1 y2 ... yN
+//   STATS         -> STATS requests=... p50_us=... p99_us=...
+//   SHUTDOWN      -> BYE (daemon band ho jata hai)
+void *daemon_client_thread(void *arg) {
+    DaemonState *ds = &daemon_state;
+    int client_fd = (int)(long)arg;
+    // Padhne aur likhne ke alag streams - ek "r+" stream mein pipelined lines buffer
+    // mein bachi hon to fprintf ko lseek chahiye, jo socket par fail hota hai
+    FILE *stream = fdopen(client_fd, "r");
+    if (!stream) {
+        close(client_fd);
+        return NULL;
+    }
+    int reply_fd = dup(client_fd);
+    FILE *out = (reply_fd >= 0) ? fdopen(reply_fd, "w") : NULL;
+    if (!out) {
+        if (reply_fd >= 0) close(reply_fd);
+        fclose(stream);
+        return NULL;
+    }
+    
+    char line[512];
+    char reply[BUFFER_SIZE];
+    InferenceRequest req;
+    pthread_cond_init(&req.done_cond, NULL);
+    
+    while (fgets(line, sizeof(line), stream)) {
+        if (strncmp(line, "INFER", 5) == 0) {
+            if (sscanf(line + 5, "%lf %lf", &req.inputs[0], &req.inputs[1]) != 2) {
+                fprintf(out, "ERR expected: INFER x1 x2\n");
+                fflush(out);
+                continue;
+            }
+            req.done = 0;
+            req.next = NULL;
+            clock_gettime(CLOCK_MONOTONIC, &req.enqueued_at);
+            
+            // Cache hit - pipeline tak jane ki zaroorat hi nahi
+            int cache_hit = ds->cache &&
+                            cache_lookup(ds->cache, CACHE_FINAL_STAGE, req.inputs, INPUT_NEURONS,
+                                         ds->model->weights_version, req.outputs);
+            
+            pthread_mutex_lock(&ds->lock);
+            if (cache_hit) {
+                struct timespec now;
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                ds->latency_us[ds->latency_count % LATENCY_SAMPLES] = elapsed_us(&req.enqueued_at, &now);
+                ds->latency_count++;
+                ds->total_requests++;
+            } else if (ds->shutting_down) {
+                pthread_mutex_unlock(&ds->lock);
+                fprintf(out, "ERR shutting down\n");
+                break;
+            } else {
+                // Queue mein daalo aur batcher ko jagao
+                if (ds->queue_tail) ds->queue_tail->next = &req;
+                else ds->queue_head = &req;
+                ds->queue_tail = &req;
+                ds->queue_len++;
+                pthread_cond_signal(&ds->queue_cond);
+                while (!req.done) {
+                    pthread_cond_wait(&req.done_cond, &ds->lock);
+                }
+            }
+            pthread_mutex_unlock(&ds->lock);
+            
+            // Seedha stream mein - bade outputs (1e150 jaise) kisi fixed buffer mein nahi aate
+            fputs("OK", out);
+            for (int i = 0; i < ds->model->neurons_per_layer; i++) {
+                fprintf(out, " %.6f", req.outputs[i]);
+            }
+            fputc('\n', out);
+        } else if (strncmp(line, "STATS", 5) == 0) {
+            format_daemon_stats(ds, reply, sizeof(reply));
+            fputs(reply, out);
+        } else if (strncmp(line, "SHUTDOWN", 8) == 0) {
+            fprintf(out, "BYE\n");
+            fflush(out);
+            ds->shutting_down = 1;
+            shutdown(ds->listen_fd, SHUT_RDWR);  // accept() ko jagao
+            break;
+        } else {
+            fprintf(out, "ERR unknown command\n");
+        }
+        fflush(out);
+    }
+    
+    pthread_cond_destroy(&req.done_cond);
+    fclose(out);
+    fclose(stream);
+    return NULL;
+}
+
+// SIGINT/SIGTERM par daemon ko saaf tareeke se band karo
+void daemon_signal_handler(int) {
+    daemon_state.shutting_down = 1;
+    shutdown(daemon_state.listen_fd, SHUT_RDWR);
+}
+
+// Daemon mode ka main - network load, stages fork, socket par requests serve
+int run_daemon(const RunOptions *opts, int hidden_layers, int neurons) {
+    const char *socket_path = opts->daemon_socket;
+    NetworkModel model;
+    if (!load_network_model("input.txt", hidden_layers, neurons, &model)) {
+        return 1;
+    }
+    
+    // Cache fork se pehle banao taake har stage process isi shared memory ko dekhe
+    // Per-layer entries (har request par har stage ki ek) apne alag cache mein - warna
+    // woh final outputs ko LRU se bahar dhakel dete. Har request stage_count entries
+    // daalta hai, isliye N x stage_count - utne hi requests yaad rehte hain jitne final mein
+    ActivationCache *cache = NULL, *layer_cache = NULL;
+    int layer_cache_entries = 0;
+    if (opts->cache_entries > 0) {
+        cache = create_activation_cache(opts->cache_entries);
+        if (!cache) return 1;
+    }
+    if (opts->cache_layers) {
+        if (opts->cache_entries > INT_MAX / 2 / model.stage_count) {
+            fprintf(stderr, "ERROR: --cache %d is too large for per-layer caching\n",
+                    opts->cache_entries);
+            return 1;
+        }
+        layer_cache_entries = opts->cache_entries * model.stage_count;
+        layer_cache = create_activation_cache(layer_cache_entries);
+        if (!layer_cache) return 1;
+    }
+    
+    // Saare stages (dono passes) ek hi resident chain mein
+    int stage_count = model.stage_count;
+    Channel pipeline_in, pipeline_out;
+    pid_t stage_pids[stage_count];
+    fork_resident_chain(&model, 0, stage_count - 1, layer_cache,
+                        opts->max_batch * execution_plan.max_width,
+                        &pipeline_in, &pipeline_out, stage_pids);
+    
+    // Unix domain socket banao
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        exit(1);
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "ERROR: Socket path too long\n");
+        exit(1);
+    }
+    strcpy(addr.sun_path, socket_path);
+    unlink(socket_path);  // Purana socket file hata do
+    if (bind(listen_fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1 ||
+        listen(listen_fd, 64) == -1) {
+        perror("bind/listen");
+        exit(1);
+    }
+    
+    DaemonState *ds = &daemon_state;
+    memset(ds, 0, sizeof(*ds));
+    ds->model = &model;
+    ds->cache = cache;
+    ds->layer_cache = layer_cache;
+    ds->max_batch = opts->max_batch;
+    ds->batch_window_us = opts->batch_window_us;
+    ds->pipeline_in = pipeline_in;
+    ds->pipeline_out = pipeline_out;
+    ds->output_bin_fd = -1;
+    if (opts->output_bin) {
+        ds->output_bin_fd = open(opts->output_bin, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (ds->output_bin_fd < 0) {
+            fprintf(stderr, "ERROR: Cannot open %s\n", opts->output_bin);
+            exit(1);
+        }
+    }
+    ds->listen_fd = listen_fd;
+    ds->max_inflight = stage_count;
+    pthread_mutex_init(&ds->lock, NULL);
+    // Batch window ki deadline enqueued_at (CLOCK_MONOTONIC) se banti hai - timedwait bhi
+    // usi clock par hona chahiye, default CLOCK_REALTIME par deadline beet chuki lagti hai
+    pthread_condattr_t queue_attr;
+    pthread_condattr_init(&queue_attr);
+    pthread_condattr_setclock(&queue_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&ds->queue_cond, &queue_attr);
+    pthread_condattr_destroy(&queue_attr);
+    pthread_cond_init(&ds->inflight_cond, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &ds->started_at);
+    
+    signal(SIGPIPE, SIG_IGN);  // Client beech mein chala jaye to crash na ho
+    signal(SIGINT, daemon_signal_handler);
+    signal(SIGTERM, daemon_signal_handler);
+    
+    pthread_t submitter, collector;
+    pthread_create(&submitter, NULL, daemon_submitter_thread, ds);
+    pthread_create(&collector, NULL, daemon_collector_thread, ds);
+    
+    printf("[DAEMON] Listening on %s (PID: %d)\n", socket_path, getpid());
+    printf("  Stages: %d | Max batch: %d | Batch window: %d us | Cache: %d entries",
+           stage_count, opts->max_batch, opts->batch_window_us, opts->cache_entries);
+    if (layer_cache) printf(" (+ %d per-layer)", layer_cache_entries);
+    printf("\n\n");
+    fflush(stdout);
+    
+    // Accept loop - har client ke liye ek detached thread
+    while (!ds->shutting_down) {
+        int client_fd = accept(listen_fd, NULL, NULL);
+        if (client_fd < 0) {
+            if (errno == EINTR) continue;
+            break;  // Shutdown ne socket band kar diya
+        }
+        pthread_t tid;
+        pthread_create(&tid, NULL, daemon_client_thread, (void *)(long)client_fd);
+        pthread_detach(tid);
+    }
+    
+    // Pending requests drain karo, phir pipeline band
+    pthread_mutex_lock(&ds->lock);
+    ds->shutting_down = 1;
+    pthread_cond_broadcast(&ds->queue_cond);
+    pthread_mutex_unlock(&ds->lock);
+    pthread_join(submitter, NULL);
+    pthread_join(collector, NULL);
+    for (int s = 0; s < stage_count; s++) {
+        waitpid(stage_pids[s], NULL, 0);
+    }
+    
+    char stats[BUFFER_SIZE];
+    format_daemon_stats(ds, stats, sizeof(stats));
+    printf("[DAEMON] Shutting down\n  %s\n", stats);
+    
+    close(listen_fd);
+    unlink(socket_path);
+    if (ds->output_bin_fd >= 0) close(ds->output_bin_fd);
+    destroy_activation_cache(cache);
+    destroy_activation_cache(layer_cache);
+    free_network_model(&model);
+    return 0;
+}
+
+// ========== ITERATIVE MODE (RESIDENT FEEDBACK LOOP) ==========
+// Forward -> backward -> forward cycle ko bar bar chalao. Iteration 1 wahi hai jo
+// normal simulation karta hai; uske baad final output par f(x1) laga kar second
+// pass ke resident workers ko wapas bhejte hain, jab tak output converge na ho
+// jaye ya iteration cap na aa jaye. Workers sirf ek baar fork aur load hote hain.
+
+int run_iterative(const RunOptions *opts, int hidden_layers, int neurons) {
+    NetworkModel model;
+    if (!load_network_model("input.txt", hidden_layers, neurons, &model)) {
+        return 1;
+    }
+    int pass_stages = hidden_layers + 2;
+    
+    // Pass 1 + backward sirf ek baar - iske workers kaam karke exit ho jate hain
+    // (pehle inko khatam karte hain taake pass 2 ke workers inke pipe ends inherit na karein)
+    Channel chain_in, chain_out;
+    pid_t first_pids[pass_stages];
+    fork_resident_chain(&model, 0, pass_stages - 1, NULL, execution_plan.max_width,
+                        &chain_in, &chain_out, first_pids);
+    
+    double feedback[MAX_NEURONS];    // Second pass ka agla input
+    double previous[MAX_NEURONS];    // Pichli iteration ka final output
+    double *output = NULL;           // channel_recv ka reusable buffer
+    int output_capacity = 0, output_count;
+    
+    int ok = channel_send(&chain_in, model.input_values, INPUT_NEURONS) &&
+             channel_recv(&chain_out, &output, &output_capacity, &output_count);
+    stop_resident_chain(&chain_in, &chain_out, first_pids, pass_stages);
+    if (!ok) {
+        fprintf(stderr, "ERROR: First forward pass failed\n");
+        free(output);
+        free_network_model(&model);
+        return 1;
+    }
+    memcpy(feedback, output, neurons * sizeof(double));  // Backward f(x1) already laga hua hai
+    
+    // Second pass ke resident workers - har iteration inhi ko reuse karti hai
+    pid_t second_pids[pass_stages];
+    fork_resident_chain(&model, pass_stages, model.stage_count - 1, NULL,
+                        execution_plan.max_width, &chain_in, &chain_out, second_pids);
+    
+    FILE *fp = fopen("output.txt", "w");
+    if (!fp) {
+        fprintf(stderr, "ERROR: Cannot write to output.txt\n");
+        stop_resident_chain(&chain_in, &chain_out, second_pids, pass_stages);
+        free(output);
+        free_network_model(&model);
+        return 1;
+    }
+    fprintf(fp, "NEURAL NETWORK ITERATIVE SIMULATION REPORT\n");
+    fprintf(fp, "==========================================\n");
+    fprintf(fp, "Configuration: %d Hidden Layers | %d Neurons Per Layer\n", hidden_layers, neurons);
+    fprintf(fp, "Iteration cap: %d | Tolerance: %g\n\n", opts->max_iterations, opts->tolerance);
+    fprintf(fp, "FORWARD PASS 1 + BACKWARD PASS (feedback input for iteration 1)\n");
+    for (int i = 0; i < neurons; i++) {
+        fprintf(fp, "  Neuron[%d] = %.6f\n", i, feedback[i]);
+    }
+    fprintf(fp, "\nITERATIONS\n");
+    
+    struct timespec started, finished;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    
+    int iteration = 0;
+    const char *outcome = "STOPPED at iteration cap";
+    while (iteration < opts->max_iterations) {
+        iteration++;
+        if (!channel_send(&chain_in, feedback, neurons) ||
+            !channel_recv(&chain_out, &output, &output_capacity, &output_count)) {
+            fprintf(stderr, "ERROR: Iteration %d failed\n", iteration);
+            stop_resident_chain(&chain_in, &chain_out, second_pids, pass_stages);
+            fclose(fp);
+            free(output);
+            free_network_model(&model);
+            return 1;
+        }
+        
+        // Convergence check - pichli iteration se sabse bada farq (pehli iteration mein
+        // previous abhi bhara nahi hai)
+        double max_delta = 0.0;
+        int finite = 1;
+        for (int i = 0; i < neurons; i++) {
+            if (iteration > 1) {
+                double delta = output[i] - previous[i];
+                if (delta < 0) delta = -delta;
+                if (delta > max_delta) max_delta = delta;
+            }
+            if (!std::isfinite(output[i])) finite = 0;
+        }
+        if (iteration == 1) {
+            fprintf(fp, "  Iteration %d: max |delta| = n/a\n", iteration);
+        } else {
+            fprintf(fp, "  Iteration %d: max |delta| = %.6e\n", iteration, max_delta);
+        }
+        memcpy(previous, output, neurons * sizeof(double));
+        
+        if (!finite) {
+            outcome = "DIVERGED (non-finite output)";
+            break;
+        }
+        if (iteration > 1 && max_delta <= opts->tolerance) {
+            outcome = "CONVERGED";
+            break;
+        }
+        
+        // Feedback - final output par backward formula laga kar agla input banao
+        memcpy(feedback, output, neurons * sizeof(double));
+        apply_backward_formula(feedback, neurons);
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    double seconds = elapsed_us(&started, &finished) / 1e6;
+    double rate = seconds > 0 ? iteration / seconds : 0.0;
+    
+    // Workers ko band karo
+    stop_resident_chain(&chain_in, &chain_out, second_pids, pass_stages);
+    
+    fprintf(fp, "\nFINAL OUTPUT (iteration %d)\n", iteration);
+    for (int i = 0; i < neurons; i++) {
+        fprintf(fp, "  Output[%d] = %.6f\n", i, previous[i]);
+    }
+    fprintf(fp, "\n%s after %d iterations\n", outcome, iteration);
+    fprintf(fp, "Throughput: %.1f iterations/sec\n", rate);
+    fclose(fp);
+    
+    printf("[ITERATIVE] %s after %d iterations (%.3f s, %.1f iterations/sec)\n\n",
+           outcome, iteration, seconds, rate);
+    
+    free(output);
+    free_network_model(&model);
+    return 0;
+}
+
+// ========== LATENCY BENCHMARK (PIPE vs SLOT RING) ==========
+// Ek-ek sample ke round trips: pehle relay chain (stages bina compute ke, sirf
+// handoff ka cost), phir poora network - dono transports par.
+
+struct LatencySummary {
+    double p50_us;
+    double p99_us;
+    double mean_us;
+};
+
+// samples round trips chain se - pehle warmup (spin budgets settle hone do), phir percentiles
+// model NULL: relay chain (stage_count stages)
+void measure_chain_latency(const NetworkModel *model, int stage_count, double *input, int width,
+                           int samples, LatencySummary *summary) {
+    Channel chain_in, chain_out;
+    pid_t pids[stage_count];
+    fork_resident_chain(model, 0, stage_count - 1, NULL, execution_plan.max_width,
+                        &chain_in, &chain_out, pids);
     
-    // Open input file for this process
-    FILE *input_fp = fopen("input.txt", "r");
-    if (!input_fp) {
-        fprintf(stderr, "ERROR: Cannot open input.txt\n");
-        fclose(local_result_file);
-        exit(1);
+    double *latencies = static_cast<double *>(malloc(samples * sizeof(double)));
+    double *output = NULL;
+    int output_capacity = 0, output_count;
+    int warmup = samples / 10 + 1;
+    for (int i = -warmup; i < samples; i++) {
+        struct timespec sent, received;
+        clock_gettime(CLOCK_MONOTONIC, &sent);
+        if (!channel_send(&chain_in, input, width) ||
+            !channel_recv(&chain_out, &output, &output_capacity, &output_count)) {
+            fprintf(stderr, "ERROR: Benchmark round trip failed\n");
+            exit(1);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &received);
+        if (i >= 0) latencies[i] = elapsed_us(&sent, &received);
+    }
+    stop_resident_chain(&chain_in, &chain_out, pids, stage_count);
+    
+    qsort(latencies, samples, sizeof(double), compare_doubles);
+    double total = 0;
+    for (int i = 0; i < samples; i++) total += latencies[i];
+    summary->p50_us = latencies[(samples - 1) * 50 / 100];
+    summary->p99_us = latencies[(samples - 1) * 99 / 100];
+    summary->mean_us = total / samples;
+    free(latencies);
+    free(output);
+}
+
+int run_latency_bench(const RunOptions *opts, int hidden_layers, int neurons) {
+    NetworkModel model;
+    if (!load_network_model("input.txt", hidden_layers, neurons, &model)) {
+        return 1;
+    }
+    int samples = opts->latency_samples;
+    int links = model.stage_count + 1;  // parent -> stage 0 -> ... -> aakhri stage -> parent
+    double activation[MAX_NEURONS];     // Relay ke liye ek layer jitna message
+    for (int i = 0; i < neurons; i++) activation[i] = 0.5;
+    
+    pin_to_cpu(0);  // Dono transports mein driver CPU 0 par
+    printf("[LATENCY] %d single-sample round trips, %d stages, %d links per trip\n\n",
+           samples, model.stage_count, links);
+    printf("  %-10s | %-22s | %-22s | %-22s\n", "transport", "relay p50/p99 (us)",
+           "per-link p50/p99 (us)", "network p50/p99 (us)");
+    
+    const char *names[2] = { "pipe", "slot-ring" };
+    for (int t = 0; t < 2; t++) {
+        low_latency = t;  // make_link isi se transport chunta hai
+        LatencySummary relay, network;
+        measure_chain_latency(NULL, model.stage_count, activation, neurons, samples, &relay);
+        measure_chain_latency(&model, model.stage_count, model.input_values, INPUT_NEURONS,
+                              samples, &network);
+        printf("  %-10s | %9.1f / %-10.1f | %9.2f / %-10.2f | %9.1f / %-10.1f\n", names[t],
+               relay.p50_us, relay.p99_us, relay.p50_us / links, relay.p99_us / links,
+               network.p50_us, network.p99_us);
+        fflush(stdout);
+    }
+    printf("\n");
+    
+    free_network_model(&model);
+    return 0;
+}
+
+// ========== PRE-FORKED WORKER POOL ==========
+// Har layer position (input, hidden 1..L, output) ka ek worker process sirf ek baar
+// fork hota hai, dono passes ke apne weights ek baar load karta hai, aur phir control
+// pipe par aane wale assignments (run + pass) chalata rehta hai. Har run mein na fork,
+// na fopen, na parse - sirf assignment aur pipes par data.
+//
+// Workers fork() se hi bante hain: unhe parent ka execution plan aur report cursor
+// chahiye. posix_spawn/vfork sirf exec ke saath kaam ke hain, aur exec ke baad plan
+// dobara banana padta - jo kaam pool bachana chahta hai.
+
+struct PoolAssignment {
+    int run_id;             // POOL_SHUTDOWN = worker band karo
+    int pass;               // 1 ya 2
+};
+
+const int POOL_SHUTDOWN = -1;
+
+struct WorkerPool {
+    int worker_count;                           // hidden_layers + 2
+    pid_t pids[MAX_HIDDEN_LAYERS + 2];
+    int control_fds[MAX_HIDDEN_LAYERS + 2];     // Parent -> worker assignments
+    int done_fd;                                // Workers -> parent (ready/done tokens)
+    int next_run;
+};
+
+// Worker position aur pass se layer spec - fork_forward_pass jaisi hi wiring
+// Links ek ring hain: worker i -> worker i+1, aur aakhri worker -> worker 0 (backward)
+LayerProcessSpec pool_layer_spec(int position, int worker_count, int pass,
+                                 int upstream_fd, int downstream_fd) {
+    LayerProcessSpec spec;
+    spec.pass = pass;
+    spec.kind = (position == 0) ? INPUT_LAYER :
+                (position == worker_count - 1) ? OUTPUT_LAYER : HIDDEN_LAYER;
+    spec.layer_num = position;
+    spec.stage_index = (pass - 1) * worker_count + position;
+    spec.num_neurons = execution_plan.neurons_per_layer;
+    spec.read_fd = (position == 0 && pass == 1) ? -1 : upstream_fd;
+    spec.write_fd = (position == worker_count - 1 && pass == 2) ? -1 : downstream_fd;
+    return spec;
+}
+
+// Worker process - weights ek baar, phir assignments ka loop
+void pool_worker_process(int position, int worker_count, int control_fd,
+                         int upstream_fd, int downstream_fd, int done_fd) {
+    // Dono passes ke weights ek saath (do prefetch threads)
+    WeightPrefetch prefetch[2];
+    double *weights[2];
+    for (int p = 0; p < 2; p++) {
+        start_weight_prefetch(&prefetch[p], &execution_plan.stages[p * worker_count + position]);
+    }
+    for (int p = 0; p < 2; p++) {
+        weights[p] = finish_weight_prefetch(&prefetch[p]);
+        if (!weights[p]) {
+            fprintf(stderr, "ERROR: Insufficient weight data for pool worker %d\n", position);
+            exit(1);
+        }
     }
     
-    // Skip: input values + input layer weights + all hidden layer weights + output layer weights
-    // + second pass input layer weights + previous second pass hidden layer weights
-    double dummy;
-    parse_double_with_comma(input_fp, &dummy);
-    parse_double_with_comma(input_fp, &dummy);
-    for (int i = 0; i < INPUT_NEURONS * num_neurons; i++) {
-        parse_double_with_comma(input_fp, &dummy);
+    int report_fd = open("output.txt", O_WRONLY);
+    if (report_fd < 0) {
+        fprintf(stderr, "ERROR: Cannot open output.txt\n");
+        exit(1);
     }
-    for (int i = 0; i < total_hidden_layers; i++) {
-        for (int j = 0; j < num_neurons * num_neurons; j++) {
-            parse_double_with_comma(input_fp, &dummy);
+    AsyncIO report_io;
+    async_io_init(&report_io);
+    
+    metrics_stage_start(position);
+    metrics_stage_start(worker_count + position);
+    
+    // Ready - parent isi token ka wait karta hai
+    if (!write_full(done_fd, &position, sizeof(int))) exit(1);
+    
+    PoolAssignment assignment;
+    while (read_full(control_fd, &assignment, sizeof(assignment)) &&
+           assignment.run_id != POOL_SHUTDOWN) {
+        LayerProcessSpec spec = pool_layer_spec(position, worker_count, assignment.pass,
+                                                upstream_fd, downstream_fd);
+        const PlanStage *stage = &execution_plan.stages[spec.stage_index];
+        print_layer_banner(&spec);
+        
+        // Plan ka shared ping-pong pair - runs bhi ek ke baad ek hain
+        double *input_data = execution_plan.activations[stage->input_buffer];
+        receive_layer_input(&spec, stage, input_data);
+        run_layer_stage(&spec, stage, weights[assignment.pass - 1], input_data,
+                        execution_plan.activations[stage->output_buffer], &report_io, report_fd);
+        fflush(stdout);
+        
+        // Report writes complete hone ke baad hi done - parent agli run mein file truncate karega
+        if (!async_io_wait_all(&report_io)) {
+            fprintf(stderr, "ERROR: Failed to write output.txt\n");
+            exit(1);
         }
+        if (!write_full(done_fd, &spec.stage_index, sizeof(int))) exit(1);
     }
-    for (int i = 0; i < num_neurons * num_neurons; i++) {
-        parse_double_with_comma(input_fp, &dummy);
+    
+    async_io_destroy(&report_io);
+    close(report_fd);
+    free(weights[0]);
+    free(weights[1]);
+    metrics_stage_finish(position);
+    metrics_stage_finish(worker_count + position);
+    exit(0);
+}
+
+// Pool fork karo aur saare workers ke ready hone ka wait karo
+void create_worker_pool(WorkerPool *pool, int hidden_layers) {
+    int count = hidden_layers + 2;
+    pool->worker_count = count;
+    pool->next_run = 0;
+    
+    int links[count][2], control[count][2], done[2];
+    for (int i = 0; i < count; i++) {
+        if (pipe(links[i]) == -1 || pipe(control[i]) == -1) {
+            perror("pipe");
+            exit(1);
+        }
     }
-    // Skip second pass input layer weights (neurons_count weights for each of neurons_count inputs)
-    for (int i = 0; i < num_neurons * num_neurons; i++) {
-        parse_double_with_comma(input_fp, &dummy);
+    if (pipe(done) == -1) {
+        perror("pipe");
+        exit(1);
     }
-    // Skip previous second pass hidden layer weights
-    for (int i = 0; i < layer_num - 1; i++) {
-        for (int j = 0; j < num_neurons * num_neurons; j++) {
-            parse_double_with_comma(input_fp, &dummy);
+    
+    for (int i = 0; i < count; i++) {
+        int upstream = links[(i + count - 1) % count][0];
+        int downstream = links[i][1];
+        fflush(stdout);
+        pool->pids[i] = fork();
+        if (pool->pids[i] == 0) {
+            // Child - apne control, upstream aur downstream ke siwa sab band
+            for (int j = 0; j < count; j++) {
+                if (links[j][0] != upstream) close(links[j][0]);
+                if (links[j][1] != downstream) close(links[j][1]);
+                close(control[j][1]);
+                if (j != i) close(control[j][0]);
+            }
+            close(done[0]);
+            pool_worker_process(i, count, control[i][0], upstream, downstream, done[1]);
+        } else if (pool->pids[i] < 0) {
+            perror("fork");
+            exit(1);
         }
     }
     
-    // Read input from previous layer
-    double *input_data;
-    int input_count;
-    if (!read_from_pipe(read_fd, &input_data, &input_count)) {
-        fprintf(stderr, "ERROR: Failed to read from pipe\n");
-        fclose(input_fp);
+    // Parent - sirf control write ends aur done read end
+    for (int i = 0; i < count; i++) {
+        close(links[i][0]);
+        close(links[i][1]);
+        close(control[i][0]);
+        pool->control_fds[i] = control[i][1];
+    }
+    close(done[1]);
+    pool->done_fd = done[0];
+    
+    for (int i = 0; i < count; i++) {
+        int token;
+        if (!read_full(pool->done_fd, &token, sizeof(int))) {
+            fprintf(stderr, "ERROR: Pool worker failed to start\n");
+            exit(1);
+        }
+    }
+}
+
+// Ek poori two-pass simulation pool par - report one-shot flow jaisi hi output.txt mein
+void run_pool_simulation(WorkerPool *pool, int hidden_layers, int neurons) {
+    FILE *fp = fopen("output.txt", "w");
+    if (!fp) {
+        fprintf(stderr, "ERROR: Cannot write to output.txt\n");
         exit(1);
     }
-    close(read_fd);
+    begin_report_file(fp, hidden_layers, neurons);
     
-    // Read weights
-    double *weights = (double *)malloc(input_count * num_neurons * sizeof(double));
-    for (int i = 0; i < input_count * num_neurons; i++) {
-        if (!parse_double_with_comma(input_fp, &weights[i])) {
-            fprintf(stderr, "ERROR: Insufficient weight data\n");
-            fclose(input_fp);
+    // Dono passes ke assignments abhi - har worker pass 1 ke baad seedha pass 2 lega
+    PoolAssignment assignment;
+    assignment.run_id = pool->next_run++;
+    for (int pass = 1; pass <= 2; pass++) {
+        assignment.pass = pass;
+        for (int i = 0; i < pool->worker_count; i++) {
+            if (!write_full(pool->control_fds[i], &assignment, sizeof(assignment))) {
+                fprintf(stderr, "ERROR: Failed to send assignment to pool worker %d\n", i);
+                exit(1);
+            }
+        }
+    }
+    for (int i = 0; i < 2 * pool->worker_count; i++) {
+        int stage_index;
+        if (!read_full(pool->done_fd, &stage_index, sizeof(int))) {
+            fprintf(stderr, "ERROR: Pool worker exited during run %d\n", assignment.run_id);
             exit(1);
         }
     }
+}
+
+void destroy_worker_pool(WorkerPool *pool) {
+    PoolAssignment shutdown = { POOL_SHUTDOWN, 0 };
+    for (int i = 0; i < pool->worker_count; i++) {
+        write_full(pool->control_fds[i], &shutdown, sizeof(shutdown));
+        close(pool->control_fds[i]);
+    }
+    for (int i = 0; i < pool->worker_count; i++) {
+        waitpid(pool->pids[i], NULL, 0);
+    }
+    close(pool->done_fd);
+}
+
+// Latencies ka summary (p50, mean) - sorted array par
+void summarize_latencies(double *latencies, int count, double *p50, double *mean) {
+    qsort(latencies, count, sizeof(double), compare_doubles);
+    double total = 0;
+    for (int i = 0; i < count; i++) total += latencies[i];
+    *p50 = latencies[(count - 1) / 2];
+    *mean = total / count;
+}
+
+// --pool-runs R: pool ek baar, phir R simulations (output.txt mein aakhri run ki report)
+// --pool-bench R: wahi R runs fork-per-layer flow se bhi, aur dono ka comparison
+int run_pool(const RunOptions *opts, int hidden_layers, int neurons) {
+    if (!build_execution_plan("input.txt", hidden_layers, neurons, &execution_plan)) {
+        return 1;
+    }
+    // Timings heap par - run count user deta hai (stack VLA bade R par overflow hota)
+    int runs = opts->pool_runs;
+    double *fork_ms = static_cast<double *>(malloc(2 * (size_t)runs * sizeof(double)));
+    if (!fork_ms) {
+        fprintf(stderr, "ERROR: Memory allocation failed\n");
+        return 1;
+    }
+    double *pool_ms = fork_ms + runs;
+    struct timespec t0, t1;
     
-    // Process with threads
-    double *output = launch_neuron_threads(num_neurons, input_count, 
-                                           input_data, weights);
+    // Bench mein layers ka console output /dev/null mein - sirf timings print hongi
+    int saved_stdout = -1;
+    if (opts->pool_bench) {
+        fflush(stdout);
+        saved_stdout = dup(STDOUT_FILENO);
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);
+        close(devnull);
+        
+        for (int r = 0; r < runs; r++) {
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            FILE *fp = fopen("output.txt", "w");
+            if (!fp) {
+                fprintf(stderr, "ERROR: Cannot write to output.txt\n");
+                free(fork_ms);
+                return 1;
+            }
+            begin_report_file(fp, hidden_layers, neurons);
+            open_weight_cache("input.txt", &execution_plan);
+            finish_weight_cache(run_forked_passes(hidden_layers, neurons, 0) == 0);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            fork_ms[r] = elapsed_us(&t0, &t1) / 1e3;
+        }
+    }
     
-    pthread_mutex_lock(&file_lock);
-    fprintf(local_result_file, "FORWARD PASS 2 - LAYER %d OUTPUT\n", layer_num);
-    fprintf(local_result_file, "Output:\n");
-    for (int i = 0; i < num_neurons; i++) {
-        fprintf(local_result_file, "  Neuron[%d] = %.6f\n", i, output[i]);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    // Header abhi - report_cursor fork se pehle map hona chahiye taaki workers share karein
+    FILE *fp = fopen("output.txt", "w");
+    if (!fp) {
+        fprintf(stderr, "ERROR: Cannot write to output.txt\n");
+        free(fork_ms);
+        return 1;
     }
-    fprintf(local_result_file, "\n");
-    fflush(local_result_file);
-    pthread_mutex_unlock(&file_lock);
+    begin_report_file(fp, hidden_layers, neurons);
+    WorkerPool pool;
+    open_weight_cache("input.txt", &execution_plan);
+    create_worker_pool(&pool, hidden_layers);   // Saare workers ke weights load ho chuke
+    finish_weight_cache(1);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double pool_start_ms = elapsed_us(&t0, &t1) / 1e3;
     
-    // Send output through pipe
-    if (!write_to_pipe(write_fd, output, num_neurons)) {
-        fprintf(stderr, "ERROR: Failed to write to pipe\n");
-        exit(1);
+    for (int r = 0; r < runs; r++) {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        run_pool_simulation(&pool, hidden_layers, neurons);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        pool_ms[r] = elapsed_us(&t0, &t1) / 1e3;
     }
+    destroy_worker_pool(&pool);
     
-    close(write_fd);
-    free(input_data);
-    free(weights);
-    free(output);
-    fclose(input_fp);
-    fclose(local_result_file);
+    if (saved_stdout >= 0) {
+        fflush(stdout);
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
     
-    exit(0);
+    double pool_p50, pool_mean;
+    summarize_latencies(pool_ms, runs, &pool_p50, &pool_mean);
+    printf("[POOL] %d workers started in %.2f ms (fork + weights, once)\n",
+           pool.worker_count, pool_start_ms);
+    printf("  Pool runs:          %d | p50 %.2f ms | mean %.2f ms\n", runs, pool_p50, pool_mean);
+    if (opts->pool_bench) {
+        double fork_p50, fork_mean;
+        summarize_latencies(fork_ms, runs, &fork_p50, &fork_mean);
+        printf("  Fork-per-layer runs: %d | p50 %.2f ms | mean %.2f ms (%d forks per run)\n",
+               runs, fork_p50, fork_mean, 2 * pool.worker_count);
+    }
+    printf("  Report of the last run saved to output.txt\n\n");
+    free(fork_ms);
+    return 0;
 }
 
-// Second forward pass - output layer
-void second_output_layer_process(int layer_num, int num_neurons, int read_fd, int total_hidden_layers) {
-    // Is process ke liye output file kholo (append mode)
-    FILE *local_result_file = fopen("output.txt", "a");
-    if (!local_result_file) {
-        fprintf(stderr, "ERROR: Cannot open output.txt\n");
-        exit(1);
+// ========== DISTRIBUTED STAGES (TCP) ==========
+// Bade models ke liye layer ranges alag hosts par chal sakti hain. Har node apni
+// range ke resident workers chalata hai: pehla stage upstream TCP connection se
+// padhta hai, aakhri stage agle node (ya launcher) ko TCP par bhejta hai. Node ke
+// andar stages ab bhi pipes se jude hain.
+
+const int NODE_CONNECT_TIMEOUT_MS = 10000;   // Downstream node ke start hone ka intezar
+const int MAX_NODES = MAX_STAGES;
+const int LAUNCHER_TIMEOUT_MS = 60000;       // Result (ya nodes ke connection) ka max intezar
+const int LAUNCHER_POLL_MS = 100;            // Itne intervals par nodes ki health check
+
+// "host:port" ko alag karo
+int parse_host_port(const char *text, char *host, size_t host_size, int *port) {
+    const char *colon = strrchr(text, ':');
+    if (!colon || colon == text || (size_t)(colon - text) >= host_size) return 0;
+    memcpy(host, text, colon - text);
+    host[colon - text] = '\0';
+    *port = atoi(colon + 1);
+    return *port > 0 && *port < 65536;
+}
+
+// "first-last" stage range parse karo
+int parse_stage_range(const char *text, int *first, int *last) {
+    return sscanf(text, "%d-%d", first, last) == 2 && *first >= 0 && *last >= *first;
+}
+
+// Node mode - apni stage range serve karo, phir upstream band hone par exit
+int run_node(const RunOptions *opts, int hidden_layers, int neurons) {
+    NetworkModel model;
+    if (!load_network_model("input.txt", hidden_layers, neurons, &model)) {
+        return 1;
+    }
+    int first, last, next_port;
+    char next_host[256];
+    if (!parse_stage_range(opts->node_stages, &first, &last) || last >= model.stage_count ||
+        !parse_host_port(opts->node_next, next_host, sizeof(next_host), &next_port)) {
+        fprintf(stderr, "ERROR: Invalid --stages or --next for this network\n");
+        return 1;
     }
+    signal(SIGPIPE, SIG_IGN);
     
-    // Open input file for this process
-    FILE *input_fp = fopen("input.txt", "r");
-    if (!input_fp) {
-        fprintf(stderr, "ERROR: Cannot open input.txt\n");
-        fclose(local_result_file);
+    int listen_fd = tcp_listen(opts->node_port);
+    if (listen_fd < 0) return 1;
+    printf("[NODE] Stages %d-%d listening on port %d, next hop %s:%d (PID: %d)\n",
+           first, last, opts->node_port, next_host, next_port, getpid());
+    fflush(stdout);
+    
+    // Pehle downstream se judo, phir upstream ka wait - chain kisi bhi order mein start ho sakti hai
+    int downstream_fd = tcp_connect_retry(next_host, next_port, NODE_CONNECT_TIMEOUT_MS);
+    if (downstream_fd < 0) return 1;
+    int upstream_fd = tcp_accept(listen_fd);
+    close(listen_fd);
+    if (upstream_fd < 0) {
+        perror("accept");
+        return 1;
+    }
+    
+    int count = last - first + 1;
+    pid_t pids[count];
+    fork_stage_range(&model, first, last, NULL, MAX_BATCH * execution_plan.max_width,
+                     make_channel(TCP_CHANNEL, upstream_fd),
+                     make_channel(TCP_CHANNEL, downstream_fd), NULL, 0, pids);
+    close(upstream_fd);
+    close(downstream_fd);
+    for (int k = 0; k < count; k++) {
+        waitpid(pids[k], NULL, 0);
+    }
+    
+    printf("[NODE] Stages %d-%d finished\n", first, last);
+    free_network_model(&model);
+    return 0;
+}
+
+// Placement file ki ek line: "host port first-last"
+struct NodePlacement {
+    char host[256];
+    int port;
+    int first, last;
+};
+
+int is_local_host(const char *host) {
+    return strcmp(host, "localhost") == 0 || strncmp(host, "127.", 4) == 0;
+}
+
+// Ek node start karo - local host par seedha fork+exec, warna ssh se usi path par
+pid_t start_node(const NodePlacement *node, const char *next, int hidden_layers, int neurons) {
+    char self_path[4096];
+    ssize_t len = readlink("/proc/self/exe", self_path, sizeof(self_path) - 1);
+    if (len < 0) {
+        perror("readlink");
         exit(1);
     }
+    self_path[len] = '\0';
     
-    // Skip: input values + input layer weights + all hidden layer weights + output layer weights
-    // + second pass input layer weights + all second pass hidden layer weights
-    double dummy;
-    parse_double_with_comma(input_fp, &dummy);
-    parse_double_with_comma(input_fp, &dummy);
-    for (int i = 0; i < INPUT_NEURONS * num_neurons; i++) {
-        parse_double_with_comma(input_fp, &dummy);
+    char port[16], stages[32], layers[16], neuron_text[16];
+    snprintf(port, sizeof(port), "%d", node->port);
+    snprintf(stages, sizeof(stages), "%d-%d", node->first, node->last);
+    snprintf(layers, sizeof(layers), "%d", hidden_layers);
+    snprintf(neuron_text, sizeof(neuron_text), "%d", neurons);
+    
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (is_local_host(node->host)) {
+            execl(self_path, self_path, "--node", port, "--stages", stages, "--next", next,
+                  "--layers", layers, "--neurons", neuron_text, (char *)NULL);
+        } else {
+            // Remote host par same directory aur binary path hone chahiye (input.txt ke saath)
+            char cwd[4096], command[2 * sizeof(self_path) + 512];
+            if (!getcwd(cwd, sizeof(cwd))) exit(1);
+            snprintf(command, sizeof(command),
+                     "cd '%s' && '%s' --node %s --stages %s --next %s --layers %s --neurons %s",
+                     cwd, self_path, port, stages, next, layers, neuron_text);
+            execlp("ssh", "ssh", node->host, command, (char *)NULL);
+        }
+        perror("exec");
+        exit(1);
+    } else if (pid < 0) {
+        perror("fork");
+        exit(1);
     }
-    for (int i = 0; i < total_hidden_layers; i++) {
-        for (int j = 0; j < num_neurons * num_neurons; j++) {
-            parse_double_with_comma(input_fp, &dummy);
+    return pid;
+}
+
+// Launcher ka intezar - fd readable ho, koi node fail ho jaye ya timeout ho jaye
+// Reap hue nodes ka pid -1 ho jata hai. Return: 1 = fd ready, 0 = failure (error print ho chuka)
+int wait_for_nodes(int fd, pid_t *node_pids, int node_count, int timeout_ms) {
+    for (int waited = 0; waited < timeout_ms; waited += LAUNCHER_POLL_MS) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, LAUNCHER_POLL_MS);
+        if (ready > 0) return 1;
+        if (ready < 0 && errno != EINTR) {
+            perror("poll");
+            return 0;
         }
+        for (int i = 0; i < node_count; i++) {
+            int status;
+            if (node_pids[i] <= 0 || waitpid(node_pids[i], &status, WNOHANG) != node_pids[i]) continue;
+            node_pids[i] = -1;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                fprintf(stderr, "ERROR: Node %d exited before the pipeline finished\n", i);
+                return 0;
+            }
+        }
+    }
+    fprintf(stderr, "ERROR: Distributed pipeline timed out after %d ms\n", timeout_ms);
+    return 0;
+}
+
+// Failure par bache hue nodes band karo aur reap karo
+void stop_nodes(pid_t *node_pids, int node_count) {
+    for (int i = 0; i < node_count; i++) {
+        if (node_pids[i] > 0) kill(node_pids[i], SIGTERM);
     }
-    for (int i = 0; i < num_neurons * num_neurons; i++) {
-        parse_double_with_comma(input_fp, &dummy);
+    for (int i = 0; i < node_count; i++) {
+        if (node_pids[i] > 0) waitpid(node_pids[i], NULL, 0);
+        node_pids[i] = -1;
+    }
+}
+
+// Launcher - placement file ke hisaab se nodes start karo, input bhejo, result lo
+int run_launcher(const RunOptions *opts, int hidden_layers, int neurons) {
+    NetworkModel model;
+    if (!load_network_model("input.txt", hidden_layers, neurons, &model)) {
+        return 1;
     }
-    // Skip second pass input layer weights
-    for (int i = 0; i < num_neurons * num_neurons; i++) {
-        parse_double_with_comma(input_fp, &dummy);
+    
+    FILE *plan_fp = fopen(opts->launch_plan, "r");
+    if (!plan_fp) {
+        fprintf(stderr, "ERROR: Cannot open placement file '%s'\n", opts->launch_plan);
+        return 1;
     }
-    // Skip all second pass hidden layer weights
-    for (int i = 0; i < total_hidden_layers; i++) {
-        for (int j = 0; j < num_neurons * num_neurons; j++) {
-            parse_double_with_comma(input_fp, &dummy);
+    NodePlacement nodes[MAX_NODES];
+    int node_count = 0;
+    char line[512], range[64];
+    while (fgets(line, sizeof(line), plan_fp)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        NodePlacement *node = &nodes[node_count];
+        if (node_count == MAX_NODES ||
+            sscanf(line, "%255s %d %63s", node->host, &node->port, range) != 3 ||
+            !parse_stage_range(range, &node->first, &node->last)) {
+            fprintf(stderr, "ERROR: Bad placement line: %s", line);
+            fclose(plan_fp);
+            return 1;
         }
+        node_count++;
     }
+    fclose(plan_fp);
     
-    // Read input from previous layer
-    double *input_data;
-    int input_count;
-    if (!read_from_pipe(read_fd, &input_data, &input_count)) {
-        fprintf(stderr, "ERROR: Failed to read from pipe\n");
-        fclose(input_fp);
-        exit(1);
+    // Ranges milkar 0..stage_count-1 bina gap ke cover karein
+    int expected = 0;
+    for (int i = 0; i < node_count; i++) {
+        if (nodes[i].first != expected) break;
+        expected = nodes[i].last + 1;
+    }
+    if (node_count == 0 || expected != model.stage_count) {
+        fprintf(stderr, "ERROR: Placement must cover stages 0-%d in order\n", model.stage_count - 1);
+        return 1;
     }
-    close(read_fd);
+    signal(SIGPIPE, SIG_IGN);
     
-    // Read weights
-    double *weights = (double *)malloc(input_count * num_neurons * sizeof(double));
-    for (int i = 0; i < input_count * num_neurons; i++) {
-        if (!parse_double_with_comma(input_fp, &weights[i])) {
-            fprintf(stderr, "ERROR: Insufficient weight data\n");
-            fclose(input_fp);
-            exit(1);
-        }
+    // Aakhri node result isi port par wapas bhejega
+    int result_listen_fd = tcp_listen(0);
+    if (result_listen_fd < 0) return 1;
+    char result_hop[300];
+    snprintf(result_hop, sizeof(result_hop), "%s:%d", opts->advertise_host,
+             tcp_local_port(result_listen_fd));
+    
+    printf("[LAUNCHER] %d nodes, %d stages\n", node_count, model.stage_count);
+    pid_t node_pids[MAX_NODES];
+    for (int i = 0; i < node_count; i++) {
+        char next[300];
+        if (i + 1 < node_count) snprintf(next, sizeof(next), "%s:%d", nodes[i + 1].host, nodes[i + 1].port);
+        else snprintf(next, sizeof(next), "%s", result_hop);
+        printf("  Node %d: %s:%d stages %d-%d -> %s\n", i, nodes[i].host, nodes[i].port,
+               nodes[i].first, nodes[i].last, next);
+        node_pids[i] = start_node(&nodes[i], next, hidden_layers, neurons);
+    }
+    
+    // Har blocking step se pehle wait_for_nodes - koi node mar jaye to launcher atke nahi
+    Channel upstream = make_channel(TCP_CHANNEL,
+                                    tcp_connect_retry(nodes[0].host, nodes[0].port,
+                                                      NODE_CONNECT_TIMEOUT_MS));
+    if (upstream.fd < 0) {
+        stop_nodes(node_pids, node_count);
+        return 1;
+    }
+    if (!wait_for_nodes(result_listen_fd, node_pids, node_count, LAUNCHER_TIMEOUT_MS)) {
+        close(upstream.fd);
+        stop_nodes(node_pids, node_count);
+        return 1;
+    }
+    Channel result = make_channel(TCP_CHANNEL, tcp_accept(result_listen_fd));
+    close(result_listen_fd);
+    if (result.fd < 0) {
+        perror("accept");
+        close(upstream.fd);
+        stop_nodes(node_pids, node_count);
+        return 1;
     }
     
-    // Process with threads
-    double *output = launch_neuron_threads(num_neurons, input_count, 
-                                           input_data, weights);
+    struct timespec started, finished;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    double *output = NULL;
+    int output_capacity = 0, output_count;
+    if (!channel_send(&upstream, model.input_values, INPUT_NEURONS) ||
+        !wait_for_nodes(result.fd, node_pids, node_count, LAUNCHER_TIMEOUT_MS) ||
+        !channel_recv(&result, &output, &output_capacity, &output_count)) {
+        fprintf(stderr, "ERROR: Distributed pipeline failed\n");
+        close(upstream.fd);
+        close(result.fd);
+        stop_nodes(node_pids, node_count);
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &finished);
     
-    pthread_mutex_lock(&file_lock);
-    fprintf(local_result_file, "FORWARD PASS 2 - FINAL OUTPUT LAYER\n");
-    fprintf(local_result_file, "Final Output:\n");
-    for (int i = 0; i < num_neurons; i++) {
-        fprintf(local_result_file, "  Output[%d] = %.6f\n", i, output[i]);
+    // Upstream band karo - EOF har node se hota hua wapas launcher tak aata hai
+    close(upstream.fd);
+    close(result.fd);
+    for (int i = 0; i < node_count; i++) {
+        if (node_pids[i] > 0) waitpid(node_pids[i], NULL, 0);
     }
-    fprintf(local_result_file, "\n");
-    fprintf(local_result_file, "SIMULATION COMPLETED SUCCESSFULLY\n");
-    fflush(local_result_file);
-    pthread_mutex_unlock(&file_lock);
     
-    free(input_data);
-    free(weights);
+    FILE *fp = fopen("output.txt", "w");
+    if (!fp) {
+        fprintf(stderr, "ERROR: Cannot write to output.txt\n");
+        return 1;
+    }
+    fprintf(fp, "NEURAL NETWORK DISTRIBUTED SIMULATION REPORT\n");
+    fprintf(fp, "============================================\n");
+    fprintf(fp, "Configuration: %d Hidden Layers | %d Neurons Per Layer\n\n", hidden_layers, neurons);
+    fprintf(fp, "PLACEMENT\n");
+    for (int i = 0; i < node_count; i++) {
+        fprintf(fp, "  %s:%d stages %d-%d\n", nodes[i].host, nodes[i].port,
+                nodes[i].first, nodes[i].last);
+    }
+    fprintf(fp, "\nFINAL OUTPUT\n");
+    for (int i = 0; i < output_count; i++) {
+        fprintf(fp, "  Output[%d] = %.6f\n", i, output[i]);
+    }
+    fprintf(fp, "\nRound trip: %.1f us\n", elapsed_us(&started, &finished));
+    fclose(fp);
+    
+    printf("[LAUNCHER] Round trip %.1f us, results saved to output.txt\n\n",
+           elapsed_us(&started, &finished));
     free(output);
-    fclose(input_fp);
-    fclose(local_result_file);
+    free_network_model(&model);
+    return 0;
+}
+
+// User se configuration input lo - kitne hidden layers aur kitne neurons
+// --layers/--neurons diye hon to prompt nahi hota (nodes aur scripts ke liye)
+void read_configuration(const RunOptions *opts, int *layers_count, int *neurons_count) {
+    if (opts->layers_count > 0 || opts->neurons_count > 0) {
+        *layers_count = opts->layers_count;
+        *neurons_count = opts->neurons_count;
+    } else {
+        // User se configuration input lo
+        printf("CONFIGURATION INPUT\n");
+        printf("-------------------\n");
+        printf("Number of hidden layers (valid range 1-%d): ", MAX_HIDDEN_LAYERS);
+        fflush(stdout);
+        
+        // Hidden layers count input lo
+        if (scanf("%d", layers_count) != 1) {
+            fprintf(stderr, "ERROR: Invalid hidden layers input\n");
+            exit(1);
+        }
+        
+        // Neurons per layer input lo
+        printf("Neurons per layer (valid range 1-100): ");
+        fflush(stdout);
+        
+        if (scanf("%d", neurons_count) != 1) {
+            fprintf(stderr, "ERROR: Invalid neurons input\n");
+            exit(1);
+        }
+    }
     
-    exit(0);
+    // Validation - range check
+    if (*layers_count < 1 || *layers_count > MAX_HIDDEN_LAYERS) {
+        fprintf(stderr, "ERROR: Hidden layers must be between 1 and %d\n", MAX_HIDDEN_LAYERS);
+        exit(1);
+    }
+    if (*neurons_count < 1 || *neurons_count > 100) {
+        fprintf(stderr, "ERROR: Neurons must be between 1 and 100\n");
+        exit(1);
+    }
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [options]\n", prog);
+    fprintf(stderr, "  (no options)            Run the two-pass simulation, report in output.txt\n");
+    fprintf(stderr, "  --incremental           One-shot run: reuse activations of unchanged layers (%s)\n",
+            CHECKPOINT_FILE);
+    fprintf(stderr, "  --iterations N          Repeat the forward/feedback cycle up to N times\n");
+    fprintf(stderr, "  --tolerance T           Stop iterating once outputs change by <= T (default %g)\n",
+            DEFAULT_TOLERANCE);
+    fprintf(stderr, "  --split-k T             Split each dot product over T threads (1-%d, chunked)\n",
+            MAX_SPLIT_K_THREADS);
+    fprintf(stderr, "  --split-k-chunk C       Split-K chunk size in inputs (default %d)\n",
+            DEFAULT_SPLIT_K_CHUNK);
+    fprintf(stderr, "  --weight-cache FILE     Keep packed weights in FILE and reuse them while input.txt is unchanged\n");
+    fprintf(stderr, "  --layers N --neurons N  Use this configuration instead of prompting\n");
+    fprintf(stderr, "  --show-plan             Print each stage's shape, weight bytes, kernel and buffers\n");
+    fprintf(stderr, "  --launch FILE           Run stage ranges on hosts from FILE (host port first-last)\n");
+    fprintf(stderr, "  --advertise HOST        Address nodes use to reach the launcher (default 127.0.0.1)\n");
+    fprintf(stderr, "  --node PORT --stages A-B --next HOST:PORT\n");
+    fprintf(stderr, "                          Serve stages A-B over TCP (started by --launch)\n");
+    fprintf(stderr, "  --low-latency           Resident stages (--daemon, --iterations, --node): pinned,\n");
+    fprintf(stderr, "                          shared-memory slots, spin-then-park\n");
+    fprintf(stderr, "  --latency-bench N       Compare pipe and slot-ring round trips over N samples\n");
+    fprintf(stderr, "  --pool-runs R           Run the simulation R times on a pre-forked worker pool\n");
+    fprintf(stderr, "  --pool-bench R          Time R pool runs against R fork-per-layer runs\n");
+    fprintf(stderr, "  --metrics FILE          Publish live per-stage counters in shared-memory page FILE\n");
+    fprintf(stderr, "  --top FILE              Watch a running simulation's metrics page (rates, utilization)\n");
+    fprintf(stderr, "  --interval-ms N         --top refresh interval (default %d)\n",
+            DEFAULT_TOP_INTERVAL_MS);
+    fprintf(stderr, "  --daemon PATH           Serve inference requests on Unix socket PATH\n");
+    fprintf(stderr, "  --max-batch N           Daemon micro-batch size (1-%d, default %d)\n",
+            MAX_BATCH, DEFAULT_MAX_BATCH);
+    fprintf(stderr, "  --batch-window-us N     Daemon batching latency budget (default %d)\n",
+            DEFAULT_BATCH_WINDOW_US);
+    fprintf(stderr, "  --cache N               Daemon: shared LRU cache of final outputs (N entries)\n");
+    fprintf(stderr, "  --cache-layers          Daemon: also cache per-layer activations in a separate\n");
+    fprintf(stderr, "                          LRU of N x stages entries (default N %d)\n",
+            DEFAULT_CACHE_ENTRIES);
+    fprintf(stderr, "  --output-bin FILE       Daemon: append each batch's inputs+outputs as raw doubles\n");
+    fprintf(stderr, "  --io-backend B          Async file I/O: auto (io_uring if available) or threads\n");
+}
+
+// argv parse karo - galat option par 0 return
+int parse_run_options(int argc, char *argv[], RunOptions *opts) {
+    opts->daemon_socket = NULL;
+    opts->max_batch = DEFAULT_MAX_BATCH;
+    opts->batch_window_us = DEFAULT_BATCH_WINDOW_US;
+    opts->cache_entries = 0;
+    opts->cache_layers = 0;
+    opts->incremental = 0;
+    opts->max_iterations = 0;
+    opts->tolerance = DEFAULT_TOLERANCE;
+    opts->layers_count = 0;
+    opts->neurons_count = 0;
+    opts->node_port = 0;
+    opts->node_stages = NULL;
+    opts->node_next = NULL;
+    opts->launch_plan = NULL;
+    opts->advertise_host = "127.0.0.1";
+    opts->output_bin = NULL;
+    opts->show_plan = 0;
+    opts->latency_samples = 0;
+    opts->pool_runs = 0;
+    opts->pool_bench = 0;
+    opts->metrics_path = NULL;
+    opts->top_path = NULL;
+    opts->top_interval_ms = DEFAULT_TOP_INTERVAL_MS;
+    
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--daemon") == 0 && value) {
+            opts->daemon_socket = value;
+            i++;
+        } else if (strcmp(arg, "--max-batch") == 0 && value) {
+            opts->max_batch = atoi(value);
+            i++;
+            if (opts->max_batch < 1 || opts->max_batch > MAX_BATCH) return 0;
+        } else if (strcmp(arg, "--batch-window-us") == 0 && value) {
+            opts->batch_window_us = atoi(value);
+            i++;
+            if (opts->batch_window_us < 0) return 0;
+        } else if (strcmp(arg, "--cache") == 0 && value) {
+            opts->cache_entries = atoi(value);
+            i++;
+            if (opts->cache_entries < 1) return 0;
+        } else if (strcmp(arg, "--cache-layers") == 0) {
+            opts->cache_layers = 1;
+        } else if (strcmp(arg, "--incremental") == 0) {
+            opts->incremental = 1;
+        } else if (strcmp(arg, "--iterations") == 0 && value) {
+            opts->max_iterations = atoi(value);
+            i++;
+            if (opts->max_iterations < 1) return 0;
+        } else if (strcmp(arg, "--tolerance") == 0 && value) {
+            opts->tolerance = atof(value);
+            i++;
+            if (opts->tolerance < 0) return 0;
+        } else if (strcmp(arg, "--layers") == 0 && value) {
+            opts->layers_count = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--neurons") == 0 && value) {
+            opts->neurons_count = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--node") == 0 && value) {
+            opts->node_port = atoi(value);
+            i++;
+            if (opts->node_port < 1 || opts->node_port > 65535) return 0;
+        } else if (strcmp(arg, "--stages") == 0 && value) {
+            opts->node_stages = value;
+            i++;
+        } else if (strcmp(arg, "--next") == 0 && value) {
+            opts->node_next = value;
+            i++;
+        } else if (strcmp(arg, "--launch") == 0 && value) {
+            opts->launch_plan = value;
+            i++;
+        } else if (strcmp(arg, "--advertise") == 0 && value) {
+            opts->advertise_host = value;
+            i++;
+        } else if (strcmp(arg, "--low-latency") == 0) {
+            low_latency = 1;  // Global - resident chains slot rings aur pinned stages lenge
+        } else if (strcmp(arg, "--latency-bench") == 0 && value) {
+            opts->latency_samples = atoi(value);
+            i++;
+            if (opts->latency_samples < 1) return 0;
+        } else if ((strcmp(arg, "--pool-runs") == 0 || strcmp(arg, "--pool-bench") == 0) && value) {
+            opts->pool_runs = atoi(value);
+            opts->pool_bench = (strcmp(arg, "--pool-bench") == 0);
+            i++;
+            if (opts->pool_runs < 1) return 0;
+        } else if (strcmp(arg, "--metrics") == 0 && value) {
+            opts->metrics_path = value;
+            i++;
+        } else if (strcmp(arg, "--top") == 0 && value) {
+            opts->top_path = value;
+            i++;
+        } else if (strcmp(arg, "--interval-ms") == 0 && value) {
+            opts->top_interval_ms = atoi(value);
+            i++;
+            if (opts->top_interval_ms < 1) return 0;
+        } else if (strcmp(arg, "--show-plan") == 0) {
+            opts->show_plan = 1;
+        } else if (strcmp(arg, "--output-bin") == 0 && value) {
+            opts->output_bin = value;
+            i++;
+        } else if (strcmp(arg, "--io-backend") == 0 && value) {
+            // Global - fork hone wale layer processes bhi yahi backend lenge
+            if (strcmp(value, "auto") == 0) async_backend = ASYNC_AUTO;
+            else if (strcmp(value, "threads") == 0) async_backend = ASYNC_THREAD;
+            else return 0;
+            i++;
+        } else if (strcmp(arg, "--split-k") == 0 && value) {
+            split_k_threads = atoi(value);  // Global - fork hone wale saare layer processes dekhenge
+            i++;
+            if (split_k_threads < 1 || split_k_threads > MAX_SPLIT_K_THREADS) return 0;
+        } else if (strcmp(arg, "--split-k-chunk") == 0 && value) {
+            split_k_chunk = atoi(value);
+            i++;
+            if (split_k_chunk < 1) return 0;
+        } else if (strcmp(arg, "--weight-cache") == 0 && value) {
+            weight_cache_path = value;  // Global - plan ke saath layer processes bhi dekhenge
+            i++;
+        } else {
+            return 0;
+        }
+    }
+    if (opts->node_port && (!opts->node_stages || !opts->node_next)) {
+        return 0;  // Node ko apni range aur agla hop pata hona chahiye
+    }
+    if (opts->cache_layers && opts->cache_entries == 0) {
+        opts->cache_entries = DEFAULT_CACHE_ENTRIES;
+    }
+    // Caches sirf daemon ki resident chain mein hain - baaki modes mein flag bekaar rehta
+    if (opts->cache_entries > 0 && !opts->daemon_socket) {
+        fprintf(stderr, "ERROR: --cache and --cache-layers need --daemon\n");
+        return 0;
+    }
+    // Checkpoint sirf one-shot fork-per-layer run padhta/likhta hai - pool aur resident
+    // modes apne workers mein saare stages hamesha compute karte hain
+    if (opts->incremental && (opts->pool_runs > 0 || opts->daemon_socket ||
+                              opts->max_iterations > 0 || opts->node_port ||
+                              opts->launch_plan || opts->latency_samples > 0)) {
+        fprintf(stderr, "ERROR: --incremental only applies to the one-shot simulation\n");
+        return 0;
+    }
+    // --low-latency sirf resident chains ka transport badalta hai - one-shot, pool aur
+    // launcher ke layer processes pipes hi use karte hain (latency bench dono khud chalata hai)
+    if (low_latency && !opts->daemon_socket && opts->max_iterations == 0 && !opts->node_port) {
+        fprintf(stderr, "ERROR: --low-latency needs --daemon, --iterations or --node\n");
+        return 0;
+    }
+    return 1;
 }
 
 // Main function - program yahan se start hota hai
-int main() {
+int main(int argc, char *argv[]) {
+    RunOptions opts;
+    if (!parse_run_options(argc, argv, &opts)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    
+    // Metrics viewer - simulation nahi chalata, sirf doosri run ka page padhta hai
+    if (opts.top_path) {
+        return run_top(opts.top_path, opts.top_interval_ms);
+    }
+    
     printf("\n");
     printf("*==================================================*\n");
     printf("*  NEURAL NETWORK MULTI-CORE SIMULATOR            *\n");
@@ -731,6 +4445,33 @@ int main() {
         exit(1);
     }
     
+    // Plan dekhna ho to bas woh print karo
+    if (opts.show_plan) {
+        int layers_count, neurons_count;
+        read_configuration(&opts, &layers_count, &neurons_count);
+        if (!build_execution_plan("input.txt", layers_count, neurons_count, &execution_plan)) {
+            return 1;
+        }
+        print_execution_plan(&execution_plan);
+        return 0;
+    }
+    
+    // Resident modes - network ek baar load hota hai, layer workers zinda rehte hain
+    if (opts.daemon_socket || opts.max_iterations > 0 || opts.node_port || opts.launch_plan ||
+        opts.latency_samples > 0 || opts.pool_runs > 0) {
+        int layers_count, neurons_count;
+        read_configuration(&opts, &layers_count, &neurons_count);
+        if (opts.metrics_path && !open_metrics_page(opts.metrics_path, layers_count, neurons_count)) {
+            return 1;
+        }
+        if (opts.pool_runs > 0) return run_pool(&opts, layers_count, neurons_count);
+        if (opts.latency_samples > 0) return run_latency_bench(&opts, layers_count, neurons_count);
+        if (opts.daemon_socket) return run_daemon(&opts, layers_count, neurons_count);
+        if (opts.node_port) return run_node(&opts, layers_count, neurons_count);
+        if (opts.launch_plan) return run_launcher(&opts, layers_count, neurons_count);
+        return run_iterative(&opts, layers_count, neurons_count);
+    }
+    
     // Files open karo - input read karne ke liye aur output write karne ke liye
     FILE *input_fp = fopen("input.txt", "r");
     // Main process opens output file in write mode (truncates file)
@@ -744,37 +4485,11 @@ int main() {
     
     // User se configuration input lo - kitne hidden layers aur kitne neurons
     int layers_count, neurons_count;
+    read_configuration(&opts, &layers_count, &neurons_count);
     
-    // User se configuration input lo
-    printf("CONFIGURATION INPUT\n");
-    printf("-------------------\n");
-    printf("Number of hidden layers (valid range 1-9): ");
-    fflush(stdout);
-    
-    // Hidden layers count input lo
-    if (scanf("%d", &layers_count) != 1) {
-        fprintf(stderr, "ERROR: Invalid hidden layers input\n");
-        exit(1);
-    }
-    
-    // Validation - range check
-    if (layers_count < 1 || layers_count > 9) {
-        fprintf(stderr, "ERROR: Hidden layers must be between 1 and 9\n");
-        exit(1);
-    }
-    
-    // Neurons per layer input lo
-    printf("Neurons per layer (valid range 1-100): ");
-    fflush(stdout);
-    
-    if (scanf("%d", &neurons_count) != 1) {
-        fprintf(stderr, "ERROR: Invalid neurons input\n");
-        exit(1);
-    }
-    
-    // Validation - range check
-    if (neurons_count < 1 || neurons_count > 100) {
-        fprintf(stderr, "ERROR: Neurons must be between 1 and 100\n");
+    // Execution plan ek baar yahin - saare layer processes fork ke saath isko inherit karenge
+    if (!build_execution_plan("input.txt", layers_count, neurons_count, &execution_plan)) {
+        fclose(result_file);
         exit(1);
     }
     
@@ -783,175 +4498,38 @@ int main() {
            layers_count, neurons_count);
     
     // Write header only once in main process (before fork)
-    fprintf(result_file, "NEURAL NETWORK SIMULATION REPORT\n");
-    fprintf(result_file, "=================================\n");
-    fprintf(result_file, "Configuration: %d Hidden Layers | %d Neurons Per Layer\n\n", 
-            layers_count, neurons_count);
-    fflush(result_file);  // Ensure header is written before fork
-    fclose(result_file);  // Close in main - children will open separately in append mode
-    
-    // ========== FORWARD PASS 1 ==========
-    // Pehla forward pass - input se output tak
-    
-    // Forward pass ke liye pipes create karo (IPC channels)
-    // Har layer ke beech mein ek pipe: input->hidden1, hidden1->hidden2, ..., hidden->output
-    int forward_pipes[layers_count + 2][2];  // +2 kyunki input->first hidden aur last hidden->output
-    for (int i = 0; i < layers_count + 2; i++) {
-        if (pipe(forward_pipes[i]) == -1) {
-            perror("pipe");
-            exit(1);
-        }
-    }
+    begin_report_file(result_file, layers_count, neurons_count);
     
-    // Backward pass ke liye pipe create karo (output se input tak)
-    int backward_pipe[2];
-    if (pipe(backward_pipe) == -1) {
-        perror("pipe");
+    // Live metrics page - layer processes fork ke saath mapping inherit karenge
+    if (opts.metrics_path && !open_metrics_page(opts.metrics_path, layers_count, neurons_count)) {
         exit(1);
     }
     
-    // Input layer process create karo (fork se)
-    // fork() ek naya process create karta hai - yeh OS concept hai
-    pid_t input_pid = fork();
-    if (input_pid == 0) {
-        // Child process - yeh input layer hai
-        close(forward_pipes[0][0]);  // Read end close karo (hum sirf write karenge)
-        input_layer_process(neurons_count, neurons_count, forward_pipes[0][1], 0);
-    } else if (input_pid < 0) {
-        perror("fork");  // Fork fail ho gaya
-        exit(1);
-    }
-    // Parent process - write end close karo (child use karega)
-    close(forward_pipes[0][1]);
-    
-    // Calculate file offsets: each process needs to know where to start reading
-    // We'll pass 0 as offset and let each process calculate based on layer number
-    // Actually simpler: calculate current file position for each layer
-    
-    // Hidden layer processes create karo - har hidden layer alag process hai
-    pid_t hidden_pids[layers_count];
-    for (int i = 0; i < layers_count; i++) {
-        hidden_pids[i] = fork();  // Naya process create karo
-        if (hidden_pids[i] == 0) {
-            // Child process - yeh hidden layer hai
-            close(forward_pipes[i][1]);      // Previous layer ka write end close
-            close(forward_pipes[i + 1][0]);  // Next layer ka read end close
-            hidden_layer_process(i + 1, neurons_count, 
-                               forward_pipes[i][0], forward_pipes[i + 1][1], 
-                               layers_count);
-        } else if (hidden_pids[i] < 0) {
-            perror("fork");
-            exit(1);
-        }
-        // Parent process - unused pipe ends close karo
-        close(forward_pipes[i][0]);
-        close(forward_pipes[i + 1][1]);
-    }
-    
-    // Output layer process create karo
-    pid_t output_pid = fork();
-    if (output_pid == 0) {
-        // Child process - yeh output layer hai
-        close(forward_pipes[layers_count][1]);  // Write end close
-        close(backward_pipe[0]);                // Backward pipe ka read end close
-        output_layer_process(layers_count + 1, neurons_count, 
-                           forward_pipes[layers_count][0], backward_pipe[1], 
-                           layers_count);
-    } else if (output_pid < 0) {
-        perror("fork");
+    // Incremental mode - pichli run ka checkpoint fork se pehle shared memory mein lao
+    if (opts.incremental && !open_checkpoint(layers_count, neurons_count)) {
         exit(1);
     }
-    // Parent process - unused ends close karo
-    close(forward_pipes[layers_count][0]);
-    close(backward_pipe[1]);
-    
-    // Sab processes ke complete hone ka wait karo (waitpid)
-    // Yeh zaroori hai taake parent process sab child processes ke khatam hone ka wait kare
-    waitpid(input_pid, NULL, 0);
-    for (int i = 0; i < layers_count; i++) {
-        waitpid(hidden_pids[i], NULL, 0);
-    }
-    waitpid(output_pid, NULL, 0);
-    
-    // ========== SECOND FORWARD PASS ==========
-    // Doosra forward pass - backward outputs ko naye inputs ki tarah use karke
-    
-    printf("[PHASE] SECOND FORWARD PASS\n");
-    printf("  Using backward outputs as new inputs...\n\n");
-    
-    // Second forward pass ke liye pipes create karo
-    int second_forward_pipes[layers_count + 2][2];
-    for (int i = 0; i < layers_count + 2; i++) {
-        if (pipe(second_forward_pipes[i]) == -1) {
-            perror("pipe");
-            exit(1);
-        }
-    }
     
-    // Fork second input layer process
-    pid_t second_input_pid = fork();
-    if (second_input_pid == 0) {
-        close(backward_pipe[1]);  // Close write end
-        close(second_forward_pipes[0][0]);  // Close read end
-        second_input_layer_process(neurons_count, neurons_count,
-                                  backward_pipe[0], second_forward_pipes[0][1], 
-                                  layers_count);
-    } else if (second_input_pid < 0) {
-        perror("fork");
-        exit(1);
-    }
-    close(backward_pipe[0]);
-    close(second_forward_pipes[0][1]);
-    
-    // Fork second hidden layer processes
-    pid_t second_hidden_pids[layers_count];
-    for (int i = 0; i < layers_count; i++) {
-        second_hidden_pids[i] = fork();
-        if (second_hidden_pids[i] == 0) {
-            close(second_forward_pipes[i][1]);
-            close(second_forward_pipes[i + 1][0]);
-            second_hidden_layer_process(i + 1, neurons_count,
-                                       second_forward_pipes[i][0], 
-                                       second_forward_pipes[i + 1][1],
-                                       layers_count);
-        } else if (second_hidden_pids[i] < 0) {
-            perror("fork");
+    // Weights ke raw bytes ka fingerprint - parse kiye bina pata chalta hai ki kaunsa prefix
+    // badla nahi; woh stages main replay karta hai, fork pehle badle stage se hota hai
+    int first_stage = 0;
+    if (checkpoint) {
+        if (!fingerprint_stage_weights("input.txt", &execution_plan)) {
             exit(1);
         }
-        close(second_forward_pipes[i][0]);
-        close(second_forward_pipes[i + 1][1]);
+        first_stage = find_incremental_resume_stage(&execution_plan);
     }
     
-    // Fork second output layer process
-    pid_t second_output_pid = fork();
-    if (second_output_pid == 0) {
-        close(second_forward_pipes[layers_count][1]);
-        second_output_layer_process(layers_count + 1, neurons_count,
-                                   second_forward_pipes[layers_count][0], 
-                                   layers_count);
-    } else if (second_output_pid < 0) {
-        perror("fork");
-        exit(1);
-    }
-    close(second_forward_pipes[layers_count][0]);
-    
-    // Wait for all second forward pass processes
-    waitpid(second_input_pid, NULL, 0);
-    for (int i = 0; i < layers_count; i++) {
-        waitpid(second_hidden_pids[i], NULL, 0);
-    }
-    waitpid(second_output_pid, NULL, 0);
+    // Packed weights ki cache file - layer processes isse padhenge ya isme likhenge
+    open_weight_cache("input.txt", &execution_plan);
+    int failed_layers = run_forked_passes(layers_count, neurons_count, first_stage);
+    // Replay hue stages ke weights load hi nahi hue - unke panels cache mein nahi likhe gaye
+    finish_weight_cache(failed_layers == 0 && first_stage == 0);
     
-    // Cleanup - sab resources free karo
-    // Pipes close karo (unnamed pipes automatically cleanup ho jati hain)
-    for (int i = 0; i < layers_count + 2; i++) {
-        close(forward_pipes[i][0]);
-        close(forward_pipes[i][1]);
-        close(second_forward_pipes[i][0]);
-        close(second_forward_pipes[i][1]);
+    // Naye activations aur fingerprints agli run ke liye save karo
+    if (checkpoint) {
+        save_checkpoint(2 * (layers_count + 2));
     }
-    close(backward_pipe[0]);
-    close(backward_pipe[1]);
     
     // Files close karo
     fclose(input_fp);